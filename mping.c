@@ -26,6 +26,8 @@
 #include <errno.h>
 #include <ifaddrs.h>
 #include <netdb.h>
+#include <stddef.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <getopt.h>
@@ -37,10 +39,20 @@
 #include <arpa/inet.h>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/resource.h>
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include "packet.h"
+#include "stats.h"
+#include "wheel.h"
+#ifdef HAVE_XDP
+#include <netpacket/packet.h>
+#include "xdp.h"
+#endif
+
 #ifndef VERSION
 #define VERSION          "2.1"
 #endif
@@ -48,53 +60,37 @@
 #define dbg(fmt,args...) do { if (debug) printf(fmt "\n", ##args); } while (0)
 #define sig(s,c)    do { struct sigaction a = {.sa_handler=c};sigaction(s,&a,0); } while(0)
 
-#if __BIG_ENDIAN__
-# define htonll(x) (x)
-# define ntohll(x) (x)
-#else
-# define htonll(x) (((uint64_t)htonl((x) & 0xFFFFFFFF) << 32) | htonl((x) >> 32))
-# define ntohll(x) (((uint64_t)ntohl((x) & 0xFFFFFFFF) << 32) | ntohl((x) >> 32))
-#endif
-
 #define MC_GROUP_DEFAULT "225.1.2.3"
 #define MC_GROUP_INET6   "ff2e::42"
 #define MC_PORT_DEFAULT  4321
 #define MC_TTL_DEFAULT   1
 
-#define MAX_BUF_LEN      2048
+#define MAX_BUF_LEN      65536
+#define MAX_UDP_LEN      65507		/* 64k - IPv4 and UDP header */
 #define MAX_HOSTNAME_LEN 256
-
-#define SENDER           's'
-#define RECEIVER         'r'
+#define MAX_BURST        1024
+#define MAX_SEGMENTS     64		/* UDP GSO max segments per send */
+#define BURST_RING       64		/* power of two */
+#define MAX_PATHS        8		/* max -i interfaces */
+#define SKEW_RING        256		/* seqnos tracked for path skew */
 
 #define INET_ADDRSTR_LEN 64
-typedef struct sockaddr_storage inet_addr_t;
-
-struct mping {
-	char            version[4];
-
-	unsigned char   type;
-	unsigned char   ttl;
-
-	inet_addr_t     src_host;
-	inet_addr_t     dest_host;
-
-	unsigned int    seq_no;
-	pid_t           pid;
-
-	struct timeval  tv;
-
-	char            payload[0];	/* optional payload */
-};
 
 /*#define BANDWIDTH 10000.0 */          /* bw in bytes/sec for mping */
 #define BANDWIDTH 100.0                 /* bw in bytes/sec for mping */
 
-#define MAX_PAYLOAD     (MAX_BUF_LEN - sizeof(struct mping))
+#define MAX_PAYLOAD     (MAX_UDP_LEN - sizeof(struct mping))
+#define SWEEP_COUNT     10		/* default packets per sweep step */
+#define SEARCH_TRIAL    10		/* default sec per search trial */
+#define SEARCH_SETTLE   2000		/* msec to wait for stragglers, RFC 2544 */
 
 /* pointer to mping packet buffer */
 struct mping *rcvd_pkt;
 
+/* probe template, built once, only seqno and timestamps patched per probe */
+char          probe_buf[MAX_BUF_LEN + 1] __attribute__((aligned(16)));
+struct mping *probe = (struct mping *)probe_buf;
+
 int   sd;                               /* socket descriptor */
 pid_t pid;                              /* our process id */
 
@@ -117,34 +113,207 @@ volatile sig_atomic_t running = 1;
 /* counters and statistics variables */
 int packets_sent = 0;
 int packets_rcvd = 0;
+unsigned long long bytes_sent = 0;
+unsigned long long bytes_rcvd = 0;
+
+/* UDP GSO, packets queued for a single segmented send */
+char   gso_buf[MAX_BUF_LEN];
+size_t gso_len = 0;
+size_t gso_seg = 0;
+size_t gso_fail = 0;	/* smallest segment size GSO failed for, 0: none */
+
+/*
+ * Burst mode accounting, one slot per in-flight burst.  A burst is
+ * reported when all replies are in, after -W SEC, or when its slot is
+ * about to be reused, replies arriving later than that are only counted
+ * in the totals.
+ */
+struct burst {
+	unsigned int    no;
+	int             sent;
+	int             rcvd;
+	unsigned char   seen[MAX_BURST / 8];
+	int             stamped;	/* replies with an arrival time */
+	uint64_t        start;		/* when sent, in ms */
+	struct timeval  first;		/* reflector arrival times */
+	struct timeval  last;
+};
+
+struct burst        bursts[BURST_RING];
+volatile int        burst_last = -1;	/* last burst started by sender */
+int                 burst_done = -1;	/* last burst reported */
+int                 bursts_rcvd = 0;
+int                 bursts_unstamped = 0;
+int                 bursts_lossy = 0;
+int                 burst_first_lost = -1;
+double              burst_disp_total = 0;
+
+/*
+ * Flow mode, one sender probing many groups, ports and intervals.  The
+ * flows are kept in a contiguous array, scheduled by a timer wheel.
+ * One socket per port, joining all groups using that port.
+ */
+struct flow {
+	struct wheel_timer  timer;	/* must be first */
+	inet_addr_t         group;	/* group and port */
+	int                 sock;	/* index in flow_socks[] */
+	int                 interval;	/* msec */
+	unsigned int        seqno;
+	int                 sent;
+	int                 rcvd;
+	double              rtt_total;
+	double              rtt_max;
+	double              rtt_min;
+};
+
+struct flow_sock {
+	int                 sd;
+	int                 port;
+	int                 groups;	/* joined */
+	int                 full;	/* join limit reached, ENOBUFS */
+};
+
+struct flow        *flows;
+int                 num_flows = 0;
+struct flow_sock   *flow_socks;
+int                 num_socks = 0;
+struct wheel        flow_wheel;
+
+/* payload size sweep, one entry per step */
+struct sweep {
+	int             len;		/* total packet length */
+	int             sent;
+	int             rcvd;
+	double          rtt_total;
+	double          rtt_max;
+	double          rtt_min;
+};
+
+struct sweep       *sweep;
+int                 sweep_steps = 0;
+int                 sweep_count = 0;	/* packets per step */
+
+/*
+ * Multi-path, one socket and join per -i interface.  Each probe is sent
+ * on all paths, tagged with the path index, the reflector replies on the
+ * same path.  Skew is the RTT difference to path 0 for the same seqno.
+ */
+struct path {
+	int                 sd;
+	int                 ifindex;
+	char                ifname[IFNAMSIZ];
+	inet_addr_t         addr;
+	struct group_req    gr;
+	int                 sent;
+	int                 rcvd;
+	double              rtt_total;
+	double              rtt_max;
+	double              rtt_min;
+	double              rtt_last;
+	double              jitter;	/* RFC 3550 interarrival jitter */
+	int                 skew_num;
+	double              skew_total;
+	double              skew_max;
+	double              skew_min;
+};
+
+struct skew {
+	unsigned int        seq_no;
+	unsigned int        seen;	/* bitmap of paths */
+	double              rtt[MAX_PATHS];
+};
+
+struct path         paths[MAX_PATHS];
+int                 num_paths = 0;
+int                 cur_path = 0;	/* set by path_select() */
+struct skew         skews[SKEW_RING];
+
+/*
+ * Throughput search, RFC 2544 style.  Each trial sends at a fixed rate
+ * for a fixed time, the rate is binary searched for the highest with
+ * loss below the threshold, per payload size.
+ */
+int                *search_best;	/* pps, per payload size */
+int                 search_sizes = 0;
+unsigned int        search_first;	/* first seqno of current trial */
+uint64_t            search_rcvd;	/* replies in current trial */
+const struct mping_stats *search_counter;	/* passive receiver, -C PID */
 
 double rtt_total = 0;
 double rtt_max   = 0;
 double rtt_min   = 999999999.0;
+uint64_t rtt_hist[STATS_BUCKETS];
+
+/* live statistics in shared memory, -P */
+struct mping_stats *shm;
+
+#ifdef HAVE_XDP
+uint64_t xdp_cnt[XDP_CNT_MAX];		/* XDP reflector counters */
+#endif
 
 /* default command-line arguments */
 char          arg_mcaddr[INET_ADDRSTR_LEN] = MC_GROUP_DEFAULT;
 int           arg_mcport     = MC_PORT_DEFAULT;
 int           arg_count      = -1;
 int           arg_payload    = 0;
+int           arg_sweep_min  = 0;
+int           arg_sweep_max  = 0;
+int           arg_sweep_step = 0;
 int           arg_timeout    = 5;
 int           arg_deadline   = 0;
+int           arg_burst      = 1;
+int           arg_interval   = 1000;
 unsigned char arg_ttl        = MC_TTL_DEFAULT;
+int           arg_gso        = 0;
+char         *arg_flows      = NULL;
+int           arg_publish    = 0;
+int           arg_xdp        = 0;
+int           arg_rate_min   = 0;
+int           arg_rate_max   = 0;
+int           arg_rate_res   = 0;
+double        arg_loss       = 0.0;
+int           arg_trial      = SEARCH_TRIAL;
+int           arg_passive    = 0;
+pid_t         arg_counter    = 0;
+char         *arg_ifaces[MAX_PATHS];
+int           num_ifaces     = 0;
+pid_t         arg_show       = 0;
 
 int debug = 0;
 int quiet = 0;
 
-static void init_socket(int family, int ifindex)
+/*
+ * Make sure socket buffers can hold a few packets of the largest size
+ * we send or expect, the kernel caps this at {r,w}mem_max.
+ */
+static void init_bufsize(int optname, int len)
+{
+	socklen_t optlen = sizeof(int);
+	int val = 0;
+
+	if (getsockopt(sd, SOL_SOCKET, optname, &val, &optlen) || val >= len)
+		return;
+
+	if (setsockopt(sd, SOL_SOCKET, optname, &len, sizeof(len)))
+		warn("Failed setting socket buffer size %d", len);
+
+	optlen = sizeof(int);
+	if (!getsockopt(sd, SOL_SOCKET, optname, &val, &optlen))
+		dbg("Socket %s buffer size %d bytes, wanted %d", optname == SO_RCVBUF ? "receive" : "send", val, len);
+}
+
+static int open_socket(int family, int ifindex)
 {
 	int off = 0;
 	int on = 1;
+	int sock;
 
 	/* create a UDP socket */
-	if ((sd = socket(family, SOCK_DGRAM, IPPROTO_UDP)) < 0)
+	if ((sock = socket(family, SOCK_DGRAM, IPPROTO_UDP)) < 0)
 		err(1, "failed creating UDP socket");
 
 	/* set reuse port to on to allow multiple binds per host */
-	if ((setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on))) < 0)
+	if ((setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on))) < 0)
 		err(1, "Failed enabling SO_REUSEADDR");
 
 #ifdef AF_INET6
@@ -153,10 +322,10 @@ static void init_socket(int family, int ifindex)
 
 		ipproto = IPPROTO_IPV6;
 
-		if (setsockopt(sd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(hops)))
+		if (setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(hops)))
 			err(1, "Failed setting IPV6_MULTICAST_HOPS: %s", strerror(errno));
 
-		if (setsockopt(sd, IPPROTO_IPV6, IPV6_MULTICAST_IF, &ifindex, sizeof(ifindex)))
+		if (setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_IF, &ifindex, sizeof(ifindex)))
 			err(1, "Failed setting IPV6_MULTICAST_IF: %s", strerror(errno));
 	} else
 #endif
@@ -165,16 +334,47 @@ static void init_socket(int family, int ifindex)
 
 		ipproto = IPPROTO_IP;
 
-		if (setsockopt(sd, IPPROTO_IP, IP_MULTICAST_TTL, &arg_ttl, sizeof(arg_ttl)))
+		if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &arg_ttl, sizeof(arg_ttl)))
 			err(1, "Failed setting IP_MULTICAST_TTL");
 
-		if (setsockopt(sd, IPPROTO_IP, IP_MULTICAST_LOOP, &off, sizeof(off)) < 0)
+		if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &off, sizeof(off)) < 0)
 			err(1, "Failed disabling IP_MULTICAST_LOOP");
 
-		if (setsockopt(sd, IPPROTO_IP, IP_MULTICAST_IF, &imr, sizeof(imr)))
+		if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &imr, sizeof(imr)))
 			err(1, "Failed setting IP_MULTICAST_IF %d", ifindex);
 	}
 
+	return sock;
+}
+
+/*
+ * Only receive groups joined on this socket.  By default Linux delivers
+ * a group joined on any socket to all sockets bound to the port.
+ */
+static void mcast_own(int sock, int family)
+{
+	int off = 0;
+
+#if defined(AF_INET6) && defined(IPV6_MULTICAST_ALL)
+	if (family == AF_INET6) {
+		if (setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_ALL, &off, sizeof(off)))
+			err(1, "Failed disabling IPV6_MULTICAST_ALL");
+	} else
+#endif
+#ifdef IP_MULTICAST_ALL
+	if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_ALL, &off, sizeof(off)))
+		err(1, "Failed disabling IP_MULTICAST_ALL");
+#else
+	(void)sock;
+	(void)family;
+	(void)off;
+#endif
+}
+
+static void init_socket(int family, int ifindex)
+{
+	sd = open_socket(family, ifindex);
+
 	/* bind to multicast address to socket */
 	if ((bind(sd, (struct sockaddr *)&mcaddr, sizeof(mcaddr))) < 0)
 		err(1, "bind() failed");
@@ -185,6 +385,51 @@ static void init_socket(int family, int ifindex)
 	gr.gr_interface = ifindex;
 	if ((setsockopt(sd, ipproto, MCAST_JOIN_GROUP, &gr, sizeof(gr))) < 0)
 		err(1, "failed joining group %s on ifindex %d", arg_mcaddr, ifindex);
+
+	/*
+	 * Only receive from our own join, not the other paths'.  The IPv6
+	 * filter matches the group but not the interface, so also bind the
+	 * socket to its interface, or all paths get each other's traffic.
+	 */
+	if (num_ifaces > 1) {
+		char ifname[IFNAMSIZ] = { 0 };
+
+		mcast_own(sd, family);
+		if (!if_indextoname(ifindex, ifname))
+			err(1, "failed looking up ifindex %d", ifindex);
+		if (setsockopt(sd, SOL_SOCKET, SO_BINDTODEVICE, ifname, strlen(ifname)) < 0)
+			err(1, "failed binding socket to %s", ifname);
+	}
+}
+
+/* UDP GRO on receive, coalesced packets are split in recv_packets() */
+static void init_offload(void)
+{
+#ifdef UDP_GRO
+	int on = 1;
+
+	if (setsockopt(sd, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) < 0)
+		err(1, "Failed enabling UDP_GRO");
+#else
+	errx(1, "UDP GSO/GRO is not supported on this system");
+#endif
+}
+
+/* largest packet we send, or may receive, of all steps and bursts */
+static void init_buffers(int sender)
+{
+	int num = arg_rate_max ? 4 * MAX_SEGMENTS : arg_burst + 3;
+	int len = MAX_BUF_LEN;
+
+	if (sender) {
+		len = arg_payload;
+		if (sweep_steps)
+			len = arg_sweep_max;
+		len += sizeof(struct mping);
+	}
+
+	init_bufsize(SO_RCVBUF, num * len);
+	init_bufsize(SO_SNDBUF, num * len);
 }
 
 static size_t strlencpy(char *dst, const char *src, size_t len)
@@ -198,8 +443,9 @@ static size_t strlencpy(char *dst, const char *src, size_t len)
 			break;
 	}
 
+	/* truncated, or exact fit, terminate inside dst */
 	if (num == 0 && len > 0)
-		*dst = 0;
+		dst[-1] = 0;
 
 	return src - p - 1;
 }
@@ -235,8 +481,8 @@ static int address_inet(const char *address, inet_addr_t *ina)
 		struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)ina;
 		void *ptr6 = &sin6->sin6_addr;
 
-		if (inet_pton(AF_INET6, arg_mcaddr, ptr6)) {
-			mcaddr.ss_family = AF_INET6;
+		if (inet_pton(AF_INET6, address, ptr6)) {
+			ina->ss_family = AF_INET6;
 			sin6->sin6_port = htons(arg_mcport);
 			return 0;
 		}
@@ -245,8 +491,8 @@ static int address_inet(const char *address, inet_addr_t *ina)
 	}
 #endif
 
-	if (inet_pton(AF_INET, arg_mcaddr, ptr)) {
-		mcaddr.ss_family = AF_INET;
+	if (inet_pton(AF_INET, address, ptr)) {
+		ina->ss_family = AF_INET;
 		sin->sin_port = htons(arg_mcport);
 		return 0;
 	}
@@ -377,36 +623,6 @@ fallback:
 	return ifany(iface, len);
 }
 
-static void hton_packet(struct mping *packet)
-{
-	packet->seq_no = htonl(packet->seq_no);
-
-	if (sizeof(packet->tv.tv_sec) == 8)
-		packet->tv.tv_sec  = htonll(packet->tv.tv_sec);
-	else
-		packet->tv.tv_sec  = htonl(packet->tv.tv_sec);
-
-	if (sizeof(packet->tv.tv_usec) == 8)
-		packet->tv.tv_usec = htonll(packet->tv.tv_usec);
-	else
-		packet->tv.tv_usec = htonl(packet->tv.tv_usec);
-}
-
-static void ntoh_packet(struct mping *packet)
-{
-	packet->seq_no = ntohl(packet->seq_no);
-
-	if (sizeof(packet->tv.tv_sec) == 8)
-		packet->tv.tv_sec  = ntohll(packet->tv.tv_sec);
-	else
-		packet->tv.tv_sec  = ntohl(packet->tv.tv_sec);
-
-	if (sizeof(packet->tv.tv_usec) == 8)
-		packet->tv.tv_usec = ntohll(packet->tv.tv_usec);
-	else
-		packet->tv.tv_usec = ntohl(packet->tv.tv_usec);
-}
-
 /* Find IP address of default outbound LAN interface */
 int ifinfo(char *iface, inet_addr_t *addr, int family)
 {
@@ -490,249 +706,1631 @@ double timeval_to_ms(const struct timeval *val)
 	return val->tv_sec * 1000.0 + val->tv_usec / 1000.0;
 }
 
-static int cleanup(void)
+static uint64_t now_ms(void)
 {
-	if ((setsockopt(sd, ipproto, MCAST_LEAVE_GROUP, &gr, sizeof(gr))) < 0)
-		err(1, "setsockopt() failed");
+	struct timespec now;
 
-	close(sd);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
 
-	printf("\n--- %s mping statistics ---\n", arg_mcaddr);
-	printf("%d packets transmitted, %d packets received\n", packets_sent, packets_rcvd);
-	if (packets_rcvd == 0)
-		printf("round-trip min/avg/max = NA/NA/NA ms\n");
-	else
-		printf("round-trip min/avg/max = %.3f/%.3f/%.3f ms\n",
-		       rtt_min, (rtt_total / packets_rcvd), rtt_max);
+static uint64_t now_ns(void)
+{
+	struct timespec now;
 
-        if (arg_count > 0 && arg_count > packets_rcvd)
-                return 1;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static int timeval_cmp(const struct timeval *a, const struct timeval *b)
+{
+	if (a->tv_sec != b->tv_sec)
+		return a->tv_sec < b->tv_sec ? -1 : 1;
+	if (a->tv_usec != b->tv_usec)
+		return a->tv_usec < b->tv_usec ? -1 : 1;
 
 	return 0;
 }
 
-static void clean_exit(int signo)
+/* arm one-shot SIGALRM timer, msec resolution */
+static void schedule(int msec)
 {
-	(void)signo;
-	running = 0;
+	struct itimerval it = {
+		.it_value = { .tv_sec = msec / 1000, .tv_usec = (msec % 1000) * 1000 }
+	};
+
+	setitimer(ITIMER_REAL, &it, NULL);
 }
 
-void send_packet(struct mping *packet, ssize_t len)
+static struct burst *burst_slot(unsigned int no)
 {
-	if ((sendto(sd, packet, len, 0, (struct sockaddr *)&mcaddr, sizeof(mcaddr))) != len)
-		err(1, "sendto() sent incorrect number of bytes");
-
-        packets_sent++;
+	return &bursts[no & (BURST_RING - 1)];
 }
 
-void send_mping(int signo)
+static void burst_start(unsigned int no)
 {
-	static char buf[MAX_BUF_LEN + 1];
-	struct mping *packet = (struct mping *)buf;
-	static int seqno = 0;
-	struct timespec now;
+	struct burst *b = burst_slot(no);
 
-        (void)signo;
-	clock_gettime(CLOCK_MONOTONIC, &now);
+	memset(b, 0, sizeof(*b));
+	b->no    = no;
+	b->start = now_ms();
+	burst_last = no;
+}
 
-        /*
-         * Tracks number of sent mpings.  If deadline mode is enabled we
-         * ignore this exit and wait for arg_count number of replies or
-         * deadline timeout.
-         */
-        if (arg_deadline) {
-		struct timeval tv;
+/* register reply, with arrival time at reflector, in its burst slot */
+static void burst_reply(const struct mping *packet)
+{
+	unsigned int no = packet_burst_no(packet);
+	unsigned int idx = packet_burst_idx(packet);
+	struct burst *b = burst_slot(no);
+	struct timeval rx_tv;
 
-		TIMESPEC_TO_TIMEVAL(&tv, &now);
-                subtract_timeval(&tv, &start);
+	if (b->no != no || (int)no <= burst_done) {
+		dbg("Late reply for burst %u, not counted in burst stats", no);
+		return;
+	}
+	if (idx >= MAX_BURST || (b->seen[idx / 8] & (1 << (idx % 8))))
+		return;
 
-		if ((arg_count > 0 && packets_rcvd >= arg_count) ||
-		    (tv.tv_sec >= arg_deadline)) {
-			running = 0;
-			return;
-		}
-	} else if (arg_count > 0 && seqno >= arg_count) {
-		sig(SIGALRM, clean_exit);
-		alarm(arg_timeout);
+	b->seen[idx / 8] |= 1 << (idx % 8);
+	b->rcvd++;
+
+	/* no arrival time, coalesced by GRO at the reflector */
+	packet_get_tv(&packet->rx_tv, &rx_tv);
+	if (!rx_tv.tv_sec && !rx_tv.tv_usec)
 		return;
+
+	if (!b->stamped++) {
+		b->first = rx_tv;
+		b->last  = rx_tv;
+	} else if (timeval_cmp(&rx_tv, &b->first) < 0) {
+		b->first = rx_tv;
+	} else if (timeval_cmp(&rx_tv, &b->last) > 0) {
+		b->last = rx_tv;
 	}
+}
 
-	memset(buf, 0, sizeof(buf));
-	TIMESPEC_TO_TIMEVAL(&packet->tv, &now);
-        strlencpy(packet->version, VERSION, sizeof(packet->version));
-	packet->type       = SENDER;
-	packet->ttl        = arg_ttl;
-	packet->src_host   = myaddr;
-	packet->dest_host  = mcaddr;
-	packet->seq_no     = seqno;
-	packet->pid        = pid;
+/* print positions of lost probes as ranges: 12-13,40,63 */
+static void burst_print_lost(const struct burst *b)
+{
+	int i, first = -1, comma = 0;
 
-	ntoh_packet(packet);
+	for (i = 0; i <= b->sent; i++) {
+		int lost = i < b->sent && !(b->seen[i / 8] & (1 << (i % 8)));
 
-	send_packet(packet, sizeof(struct mping) + arg_payload);
-	seqno++;
+		if (lost) {
+			if (first == -1)
+				first = i;
+			continue;
+		}
+		if (first == -1)
+			continue;
 
-	/* set another alarm call to send in 1 second */
-	sig(SIGALRM, send_mping);
-	alarm(1);
+		printf("%s%d", comma++ ? "," : "", first);
+		if (i - 1 > first)
+			printf("-%d", i - 1);
+		first = -1;
+	}
 }
 
-int process_mping(char *packet, int len, unsigned char type)
+static void burst_report(unsigned int no)
 {
-	if (len < (int)sizeof(struct mping)) {
-		dbg("Discarding packet: too small (%zu bytes)", strlen(packet));
-		return -1;
+	struct burst *b = burst_slot(no);
+	struct timeval disp = b->last;
+	int i, lost = -1;
+
+	for (i = 0; i < b->sent; i++) {
+		if (!(b->seen[i / 8] & (1 << (i % 8)))) {
+			lost = i;
+			break;
+		}
 	}
 
-	rcvd_pkt = (struct mping *)packet;
+	subtract_timeval(&disp, &b->first);
+	if (b->rcvd && b->stamped == b->rcvd) {
+		burst_disp_total += timeval_to_ms(&disp);
+		bursts_rcvd++;
+	} else if (b->rcvd) {
+		bursts_unstamped++;
+	}
+	if (lost != -1) {
+		bursts_lossy++;
+		if (burst_first_lost == -1 || lost < burst_first_lost)
+			burst_first_lost = lost;
+	}
+	burst_done = no;
 
-	ntoh_packet(rcvd_pkt);
+	if (quiet)
+		return;
 
-	if (strcmp(rcvd_pkt->version, VERSION)) {
-		dbg("Discarding packet: version mismatch (%s)", rcvd_pkt->version);
-		return -1;
+	printf("burst %u: %d sent, %d received", no, b->sent, b->rcvd);
+	if (lost != -1) {
+		printf(", first lost #%d, lost #", lost);
+		burst_print_lost(b);
 	}
+	if (b->rcvd && b->stamped == b->rcvd)
+		printf(", dispersion %.3f ms", timeval_to_ms(&disp));
+	else if (b->rcvd)
+		printf(", dispersion NA");
+	printf("\n");
+}
 
-	if (rcvd_pkt->type != type) {
-		if (debug) {
-			switch (rcvd_pkt->type) {
-			case SENDER:
-				printf("Discarding sender packet\n");
-				break;
+/* report bursts in order, as they complete or time out, or all at exit */
+static void burst_flush(int all)
+{
+	uint64_t now = now_ms();
 
-			case RECEIVER:
-				printf("Discarding receiver packet\n");
-				break;
+	while (burst_done < burst_last) {
+		struct burst *b = burst_slot(burst_done + 1);
 
-			case '?':
-				printf("Discarding packet: unknown type(%c)\n", rcvd_pkt->type);
-				break;
-			}
-		}
+		if (!all && !(b->sent && b->rcvd >= b->sent) &&
+		    burst_last - burst_done < BURST_RING &&
+		    now - b->start < (uint64_t)arg_timeout * 1000)
+			break;	/* wait for more replies */
 
-		return -1;
+		burst_report(burst_done + 1);
 	}
+}
 
-	if (rcvd_pkt->type == RECEIVER) {
-		if (rcvd_pkt->pid != pid) {
-			dbg("Discarding packet: pid mismatch (%u/%u)", pid, rcvd_pkt->pid);
-			return -1;
-		}
+static void rtt_account(double rtt)
+{
+	/* keep rtt total, min and max */
+	rtt_total += rtt;
+	if (rtt > rtt_max)
+		rtt_max = rtt;
+	if (rtt < rtt_min)
+		rtt_min = rtt;
+
+	rtt_hist[stats_bucket(rtt)]++;
+}
+
+/* update shared memory statistics, from main loop only, single writer */
+static void publish(void)
+{
+	if (!shm)
+		return;
+
+	stats_begin(shm);
+	shm->updated    = now_ms();
+	shm->sent       = packets_sent;
+	shm->rcvd       = packets_rcvd;
+#ifdef HAVE_XDP
+	shm->sent      += xdp_cnt[XDP_CNT_TX];
+	shm->rcvd      += xdp_cnt[XDP_CNT_RX];
+#endif
+	shm->bytes_sent = bytes_sent;
+	shm->bytes_rcvd = bytes_rcvd;
+	shm->rtt_min    = rtt_min > rtt_max ? 0 : rtt_min;
+	shm->rtt_max    = rtt_max;
+	shm->rtt_total  = rtt_total;
+	memcpy(shm->hist, rtt_hist, sizeof(shm->hist));
+	stats_end(shm);
+}
+
+static int init_sweep(void)
+{
+	int i;
+
+	if (arg_sweep_step <= 0)
+		arg_sweep_step = (arg_sweep_max - arg_sweep_min) / 10;
+	if (arg_sweep_step <= 0)
+		arg_sweep_step = 1;
+
+	/* last step is always MAX, also when the range is not whole steps */
+	sweep_steps = (arg_sweep_max - arg_sweep_min + arg_sweep_step - 1) / arg_sweep_step + 1;
+	sweep = calloc(sweep_steps, sizeof(struct sweep));
+	if (!sweep)
+		err(1, "failed allocating sweep table");
+
+	for (i = 0; i < sweep_steps; i++) {
+		int size = arg_sweep_min + i * arg_sweep_step;
+
+		if (size > arg_sweep_max)
+			size = arg_sweep_max;
+		sweep[i].len     = sizeof(struct mping) + size;
+		sweep[i].rtt_min = 999999999.0;
 	}
 
-	packets_rcvd++;
+	sweep_count = arg_count > 0 ? arg_count : SWEEP_COUNT;
 
-	return 0;
+	return sweep_steps * sweep_count;
 }
 
-void sender_listen_loop(void)
+static void sweep_reply(unsigned int seqno, double rtt)
 {
-	send_mping(0);
+	struct sweep *step;
 
-	while (running) {
-                char recv_packet[MAX_BUF_LEN + 1] = { 0 };
-                int len;
+	if (seqno / sweep_count >= (unsigned int)sweep_steps)
+		return;
 
-		if ((len = recvfrom(sd, recv_packet, MAX_BUF_LEN, 0, NULL, 0)) < 0) {
-			if (errno == EINTR)
-				continue; /* interrupt is ok */
-                        err(1, "recvfrom() failed");
-		}
+	step = &sweep[seqno / sweep_count];
+	step->rcvd++;
+	step->rtt_total += rtt;
+	if (rtt > step->rtt_max)
+		step->rtt_max = rtt;
+	if (rtt < step->rtt_min)
+		step->rtt_min = rtt;
+}
 
-		if (process_mping(recv_packet, len, RECEIVER) == 0) {
-			struct timespec now;
-                        struct timeval tv;
-                        double rtt;		/* round trip time */
+static void sweep_report(void)
+{
+	int i;
+
+	printf("\n--- %s payload size sweep ---\n", arg_mcaddr);
+	printf("  bytes    sent    rcvd    loss       min       avg       max\n");
+	for (i = 0; i < sweep_steps; i++) {
+		struct sweep *step = &sweep[i];
+
+		printf("%7d %7d %7d %6.1f%%", step->len, step->sent, step->rcvd,
+		       step->sent ? 100.0 * (step->sent - step->rcvd) / step->sent : 0.0);
+		if (step->rcvd)
+			printf(" %9.3f %9.3f %9.3f\n", step->rtt_min,
+			       step->rtt_total / step->rcvd, step->rtt_max);
+		else
+			printf(" %9s %9s %9s\n", "NA", "NA", "NA");
+	}
+}
 
-                        clock_gettime(CLOCK_MONOTONIC, &now);
-			TIMESPEC_TO_TIMEVAL(&tv, &now);
+/* make path the current, receive and reply on its socket */
+static void path_select(int i)
+{
+	cur_path = i;
+	sd       = paths[i].sd;
+	myaddr   = paths[i].addr;
+	gr       = paths[i].gr;
+}
 
-			/* calculate round trip time in milliseconds */
-			subtract_timeval(&tv, &rcvd_pkt->tv);
-			rtt = timeval_to_ms(&tv);
+/* return index of a readable path, or -1 on timeout/signal */
+static int path_wait(void)
+{
+	struct pollfd pfd[MAX_PATHS];
+	int i;
 
-			/* keep rtt total, min and max */
-			rtt_total += rtt;
-			if (rtt > rtt_max)
-				rtt_max = rtt;
-			if (rtt < rtt_min)
-				rtt_min = rtt;
+	if (num_paths < 2)
+		return 0;	/* single path, block in recv */
 
-			/* output received packet information */
-                        if (!quiet)
-                                printf("%d bytes from %s: seqno=%u ttl=%d time=%.1f ms\n",
-                                       len, inet_address(&rcvd_pkt->src_host, NULL, 0),
-                                       rcvd_pkt->seq_no, rcvd_pkt->ttl, rtt);
-		}
+	for (i = 0; i < num_paths; i++) {
+		pfd[i].fd     = paths[i].sd;
+		pfd[i].events = POLLIN;
+	}
+
+	if (poll(pfd, num_paths, -1) <= 0)
+		return -1;
+
+	for (i = 0; i < num_paths; i++) {
+		if (pfd[i].revents & POLLIN)
+			return i;
+	}
+
+	return -1;
+}
+
+static void path_reply(struct path *p, unsigned int seqno, double rtt)
+{
+	struct skew *sk = &skews[seqno % SKEW_RING];
+	unsigned int all = (1U << num_paths) - 1;
+	double delta = rtt - p->rtt_last;
+	int i;
+
+	p->rcvd++;
+	p->rtt_total += rtt;
+	if (rtt > p->rtt_max)
+		p->rtt_max = rtt;
+	if (rtt < p->rtt_min)
+		p->rtt_min = rtt;
+	if (delta < 0)
+		delta = -delta;
+	if (p->rcvd > 1)
+		p->jitter += (delta - p->jitter) / 16;
+	p->rtt_last = rtt;
+
+	if (sk->seq_no != seqno || !sk->seen) {
+		sk->seq_no = seqno;
+		sk->seen   = 0;
+	}
+	sk->rtt[p - paths] = rtt;
+	sk->seen |= 1U << (p - paths);
+	if (sk->seen != all)
+		return;
+
+	/* all paths replied for this seqno */
+	for (i = 1; i < num_paths; i++) {
+		struct path *q = &paths[i];
+		double skew = sk->rtt[i] - sk->rtt[0];
+
+		if (!q->skew_num || skew > q->skew_max)
+			q->skew_max = skew;
+		if (!q->skew_num || skew < q->skew_min)
+			q->skew_min = skew;
+		q->skew_total += skew;
+		q->skew_num++;
 	}
+	sk->seen = 0;
 }
 
-void receiver_listen_loop(void)
+/* replies received, with multiple paths, the least of any path */
+static int path_rcvd(void)
 {
-	printf("Listening on %s:%d\n", arg_mcaddr, arg_mcport);
+	int i, min = packets_rcvd;
 
-	while (running) {
-                char recv_packet[MAX_BUF_LEN + 1];
-                int len;
+	if (num_paths < 2)
+		return packets_rcvd;
 
-		if ((len = recvfrom(sd, recv_packet, MAX_BUF_LEN, 0, NULL, 0)) < 0) {
-			if (errno == EINTR)
-                                continue; /* interrupt is ok */
+	for (i = 0; i < num_paths; i++) {
+		if (i == 0 || paths[i].rcvd < min)
+			min = paths[i].rcvd;
+	}
 
-                        err(1, "recvfrom() failed");
-		}
+	return min;
+}
 
-		if (process_mping(recv_packet, len, SENDER) == 0) {
-                        if (!quiet)
-                                printf("Received mping from %s bytes=%d seqno=%u ttl=%d\n",
-                                       inet_address(&rcvd_pkt->src_host, NULL, 0),
-                                       len, rcvd_pkt->seq_no, rcvd_pkt->ttl);
+static void path_report(void)
+{
+	int i;
+
+	printf("\n%4s %-15s %7s %7s %6s %9s %9s %9s %9s\n", "path", "iface",
+	       "sent", "rcvd", "loss", "min", "avg", "max", "jitter");
+	for (i = 0; i < num_paths; i++) {
+		struct path *p = &paths[i];
+		double loss = p->sent ? 100.0 * (p->sent - p->rcvd) / p->sent : 0;
+
+		printf("%4d %-15s %7d %7d %5.1f%%", i, p->ifname, p->sent, p->rcvd,
+		       loss < 0 ? 0 : loss);
+		if (p->rcvd)
+			printf(" %9.3f %9.3f %9.3f %9.3f\n", p->rtt_min,
+			       p->rtt_total / p->rcvd, p->rtt_max, p->jitter);
+		else
+			printf(" %9s %9s %9s %9s\n", "NA", "NA", "NA", "NA");
+	}
+
+	for (i = 1; i < num_paths; i++) {
+		struct path *p = &paths[i];
+
+		printf("skew %s-%s min/avg/max = ", p->ifname, paths[0].ifname);
+		if (p->skew_num)
+			printf("%.3f/%.3f/%.3f ms (%d seqnos)\n", p->skew_min,
+			       p->skew_total / p->skew_num, p->skew_max, p->skew_num);
+		else
+			printf("NA/NA/NA ms\n");
+	}
+}
+
+static int search_len(int i)
+{
+	if (sweep_steps)
+		return sweep[i].len;
 
-			rcvd_pkt->type       = RECEIVER;
-			rcvd_pkt->src_host   = myaddr;
-			rcvd_pkt->dest_host  = rcvd_pkt->src_host;
+	return sizeof(struct mping) + arg_payload;
+}
 
-			hton_packet(rcvd_pkt);
+static int search_report(void)
+{
+	int i, rc = 0;
 
-                        /* send reply immediately */
-			send_packet(rcvd_pkt, len);
+	printf("\n--- %s throughput, loss <= %g%% ---\n", arg_mcaddr, arg_loss);
+	printf("%7s %10s %10s\n", "bytes", "pps", "Mbit/s");
+	for (i = 0; i < search_sizes; i++) {
+		int len = search_len(i);
 
-			if (arg_count > 0 && packets_sent >= arg_count)
-				exit(0);
+		if (!search_best[i]) {
+			printf("%7d %10s %10s\n", len, "NA", "NA");
+			rc = 1;
+			continue;
 		}
+
+		printf("%7d %10d %10.2f\n", len, search_best[i],
+		       (double)search_best[i] * len * 8 / 1e6);
 	}
+
+	return rc;
 }
 
-int usage(void)
+static int cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < num_paths; i++) {
+		struct path *p = &paths[i];
+
+		if ((setsockopt(p->sd, ipproto, MCAST_LEAVE_GROUP, &p->gr, sizeof(p->gr))) < 0)
+			err(1, "setsockopt() failed");
+
+		close(p->sd);
+	}
+
+	if (burst_last >= 0)
+		burst_flush(1);
+
+	printf("\n--- %s mping statistics ---\n", arg_mcaddr);
+	printf("%d packets transmitted, %d packets received\n", packets_sent, packets_rcvd);
+	if (packets_rcvd == 0 || rtt_min > rtt_max)
+		printf("round-trip min/avg/max = NA/NA/NA ms\n");
+	else
+		printf("round-trip min/avg/max = %.3f/%.3f/%.3f ms\n",
+		       rtt_min, (rtt_total / packets_rcvd), rtt_max);
+#ifdef HAVE_XDP
+	if (arg_xdp)
+		printf("xdp: %llu packets received, %llu reflected, %llu invalid\n",
+		       (unsigned long long)xdp_cnt[XDP_CNT_RX],
+		       (unsigned long long)xdp_cnt[XDP_CNT_TX],
+		       (unsigned long long)xdp_cnt[XDP_CNT_INVALID]);
+#endif
+
+	if (arg_gso || arg_burst > 1) {
+		double gbit = (bytes_sent + bytes_rcvd) * 8 / 1e9;
+		struct rusage ru;
+		double usr, sys;
+
+		getrusage(RUSAGE_SELF, &ru);
+		usr = timeval_to_ms(&ru.ru_utime);
+		sys = timeval_to_ms(&ru.ru_stime);
+		printf("cpu user/sys = %.0f/%.0f ms", usr, sys);
+		if (gbit > 0)
+			printf(", %.1f ms/Gbit", (usr + sys) / gbit);
+		printf("%s\n", arg_gso ? " (gso/gro)" : "");
+	}
+
+	if (burst_last >= 0) {
+		int num = burst_last + 1;
+
+		printf("%d bursts of %d, %d with loss", num, arg_burst, bursts_lossy);
+		if (burst_first_lost != -1)
+			printf(", earliest loss at #%d", burst_first_lost);
+		if (bursts_rcvd)
+			printf(", avg dispersion %.3f ms", burst_disp_total / bursts_rcvd);
+		else if (bursts_unstamped)
+			printf(", avg dispersion NA");
+		if (bursts_unstamped)
+			printf(" (%d NA, GRO at reflector)", bursts_unstamped);
+		printf("\n");
+	}
+
+	if (sweep_steps && !search_sizes)
+		sweep_report();
+
+	if (search_sizes)
+		return search_report();
+
+	if (num_paths > 1) {
+		path_report();
+		for (i = 0; i < num_paths; i++) {
+			if (arg_count > 0 && arg_count > paths[i].rcvd)
+				return 1;
+		}
+		return 0;
+	}
+
+        if (arg_count > 0 && arg_count > packets_rcvd)
+                return 1;
+
+	return 0;
+}
+
+static void clean_exit(int signo)
+{
+	(void)signo;
+	running = 0;
+}
+
+void send_packet(struct mping *packet, ssize_t len)
+{
+	if ((sendto(sd, packet, len, 0, (struct sockaddr *)&mcaddr, sizeof(mcaddr))) != len)
+		err(1, "sendto() sent incorrect number of bytes");
+
+        packets_sent++;
+	bytes_sent += len;
+}
+
+/*
+ * Send all queued packets in one syscall, the kernel (or NIC) splits
+ * them into gso_seg sized datagrams.  If the segment size exceeds the
+ * MTU, or GSO is not supported, fall back to one sendto() per packet.
+ */
+static void gso_flush(void)
+{
+	size_t off;
+
+	if (!gso_len)
+		return;
+
+#ifdef UDP_SEGMENT
+	if (gso_len > gso_seg) {
+		char control[CMSG_SPACE(sizeof(uint16_t))] = { 0 };
+		struct iovec iov = {
+			.iov_base = gso_buf,
+			.iov_len  = gso_len
+		};
+		struct msghdr msg = {
+			.msg_name       = &mcaddr,
+			.msg_namelen    = sizeof(mcaddr),
+			.msg_iov        = &iov,
+			.msg_iovlen     = 1,
+			.msg_control    = control,
+			.msg_controllen = sizeof(control)
+		};
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		uint16_t segsz = gso_seg;
+
+		cmsg->cmsg_level = IPPROTO_UDP;
+		cmsg->cmsg_type  = UDP_SEGMENT;
+		cmsg->cmsg_len   = CMSG_LEN(sizeof(segsz));
+		memcpy(CMSG_DATA(cmsg), &segsz, sizeof(segsz));
+
+		if (sendmsg(sd, &msg, 0) == (ssize_t)gso_len) {
+			packets_sent += (gso_len + gso_seg - 1) / gso_seg;
+			bytes_sent   += gso_len;
+			gso_len = 0;
+			return;
+		}
+
+		/* e.g., larger than MTU, smaller segments may still work */
+		warn("UDP GSO send of %zu byte segments failed, sending those one by one", gso_seg);
+		if (!gso_fail || gso_seg < gso_fail)
+			gso_fail = gso_seg;
+	}
+#endif
+
+	for (off = 0; off < gso_len; off += gso_seg) {
+		size_t len = gso_len - off < gso_seg ? gso_len - off : gso_seg;
+
+		send_packet((struct mping *)&gso_buf[off], len);
+	}
+	gso_len = 0;
+}
+
+/* queue packet for segmented send, or send immediately w/o GSO */
+static void gso_queue(struct mping *packet, size_t len)
+{
+	if (!arg_gso || (gso_fail && len >= gso_fail)) {
+		gso_flush();
+		send_packet(packet, len);
+		return;
+	}
+
+	if (gso_len && (len != gso_seg || gso_len + len > MAX_UDP_LEN ||
+			gso_len / gso_seg >= MAX_SEGMENTS))
+		gso_flush();
+
+	memcpy(&gso_buf[gso_len], packet, len);
+	gso_len += len;
+	gso_seg  = len;
+}
+
+/* send a copy of the probe on each path, tagged with the path index */
+static void send_paths(struct mping *packet, size_t len)
+{
+	int i;
+
+	if (num_paths < 2) {
+		gso_queue(packet, len);
+		return;
+	}
+
+	for (i = 0; i < num_paths; i++) {
+		struct path *p = &paths[i];
+
+		packet->path     = i;
+		packet->src_host = p->addr;
+		if ((sendto(p->sd, packet, len, 0, (struct sockaddr *)&mcaddr, sizeof(mcaddr))) != (ssize_t)len)
+			err(1, "sendto() on %s sent incorrect number of bytes", p->ifname);
+
+		packets_sent++;
+		bytes_sent += len;
+		p->sent++;
+	}
+}
+
+/*
+ * Receive one datagram, or with UDP GRO, a train of coalesced datagrams
+ * of segsz bytes each, the last may be shorter.
+ */
+static int recv_packets(char *buf, size_t len, int *segsz)
+{
+	char control[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len  = len
+	};
+	struct msghdr msg = {
+		.msg_iov        = &iov,
+		.msg_iovlen     = 1,
+		.msg_control    = control,
+		.msg_controllen = sizeof(control)
+	};
+	struct cmsghdr *cmsg;
+	ssize_t num;
+
+	num = recvmsg(sd, &msg, 0);
+	if (num < 0)
+		return -1;
+
+	*segsz = num;
+#ifdef UDP_GRO
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO)
+			memcpy(segsz, CMSG_DATA(cmsg), sizeof(int));
+	}
+#else
+	(void)cmsg;
+#endif
+	if (*segsz <= 0)
+		*segsz = num;
+
+	return num;
+}
+
+/* GRO segments are at odd offsets, copy to keep struct mping aligned */
+static char *segment(char *buf, int off, int len)
+{
+	static char seg[MAX_BUF_LEN + 1] __attribute__((aligned(16)));
+
+	if (!off)
+		return buf;
+
+	memcpy(seg, &buf[off], len);
+	return seg;
+}
+
+/* build probe template once, for the largest payload we send */
+static void init_probe(void)
+{
+	int len = arg_sweep_max > arg_payload ? arg_sweep_max : arg_payload;
+
+	packet_init(probe, sizeof(struct mping) + len, arg_ttl, &myaddr, &mcaddr, pid);
+}
+
+void send_mping(int signo)
+{
+	static unsigned int burstno = 0;
+	size_t len = sizeof(struct mping) + arg_payload;
+	static int seqno = 0;
+	struct timespec now;
+	int i;
+
+        (void)signo;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+        /*
+         * Tracks number of sent mpings.  If deadline mode is enabled we
+         * ignore this exit and wait for arg_count number of replies or
+         * deadline timeout.
+         */
+        if (arg_deadline) {
+		struct timeval tv;
+
+		TIMESPEC_TO_TIMEVAL(&tv, &now);
+                subtract_timeval(&tv, &start);
+
+		if ((arg_count > 0 && path_rcvd() >= arg_count) ||
+		    (tv.tv_sec >= arg_deadline)) {
+			running = 0;
+			return;
+		}
+	} else if (arg_count > 0 && seqno >= arg_count) {
+		sig(SIGALRM, clean_exit);
+		alarm(arg_timeout);
+		return;
+	}
+
+	if (arg_burst > 1)
+		burst_start(burstno);
+
+	/* in burst mode, send back-to-back, as fast as the socket allows */
+	for (i = 0; i < arg_burst; i++) {
+		if (!arg_deadline && arg_count > 0 && seqno >= arg_count)
+			break;
+		if (i > 0)
+			clock_gettime(CLOCK_MONOTONIC, &now);
+		if (sweep_steps) {
+			struct sweep *step = &sweep[seqno / sweep_count];
+
+			len = step->len;
+			step->sent++;
+		}
+
+		packet_stamp(probe, seqno, &now);
+		if (arg_burst > 1)
+			packet_burst(probe, burstno, i, arg_burst);
+
+		send_paths(probe, len);
+		seqno++;
+	}
+	gso_flush();
+
+	if (arg_burst > 1)
+		burst_slot(burstno++)->sent = i;
+
+	/* set another alarm call to send in 1 second, or burst interval */
+	sig(SIGALRM, send_mping);
+	schedule(arg_interval);
+}
+
+/* validate received packet, read-only, rcvd_pkt is left in network order */
+int process_mping(char *packet, int len, unsigned char type)
+{
+	rcvd_pkt = (struct mping *)packet;
+
+	switch (packet_check(packet, len, type)) {
+	case PACKET_SHORT:
+		dbg("Discarding packet: too small (%d bytes)", len);
+		return -1;
+
+	case PACKET_VERSION:
+		dbg("Discarding packet: version mismatch (%.*s)",
+		    (int)sizeof(rcvd_pkt->version), rcvd_pkt->version);
+		return -1;
+
+	case PACKET_TYPE:
+		if (debug) {
+			switch (rcvd_pkt->type) {
+			case SENDER:
+				printf("Discarding sender packet\n");
+				break;
+
+			case RECEIVER:
+				printf("Discarding receiver packet\n");
+				break;
+
+			case '?':
+				printf("Discarding packet: unknown type(%c)\n", rcvd_pkt->type);
+				break;
+			}
+		}
+
+		return -1;
+	}
+
+	if (type == RECEIVER) {
+		if (rcvd_pkt->pid != pid) {
+			dbg("Discarding packet: pid mismatch (%u/%u)", pid, rcvd_pkt->pid);
+			return -1;
+		}
+		if (num_flows && packet_flow(rcvd_pkt) >= (unsigned int)num_flows) {
+			dbg("Discarding packet: unknown flow %u", packet_flow(rcvd_pkt));
+			return -1;
+		}
+		if (num_paths > 1 && rcvd_pkt->path != cur_path) {
+			dbg("Discarding packet: path %u reply on path %d", rcvd_pkt->path, cur_path);
+			return -1;
+		}
+	}
+
+	packets_rcvd++;
+
+	return 0;
+}
+
+static void sender_reply(char *packet, int len)
+{
+	struct timespec now;
+	struct timeval tv, sent;
+	unsigned int seqno;
+	double rtt;		/* round trip time */
+
+	if (process_mping(packet, len, RECEIVER))
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	TIMESPEC_TO_TIMEVAL(&tv, &now);
+	bytes_rcvd += len;
+
+	/* calculate round trip time in milliseconds */
+	packet_get_tv(&rcvd_pkt->tv, &sent);
+	subtract_timeval(&tv, &sent);
+	rtt = timeval_to_ms(&tv);
+	seqno = packet_seqno(rcvd_pkt);
+
+	rtt_account(rtt);
+
+	if (packet_burst_len(rcvd_pkt) > 1)
+		burst_reply(rcvd_pkt);
+	if (sweep_steps)
+		sweep_reply(seqno, rtt);
+	if (num_paths > 1)
+		path_reply(&paths[cur_path], seqno, rtt);
+
+	/* output received packet information */
+	if (quiet)
+		return;
+	if (num_paths > 1)
+		printf("%d bytes from %s via %s: seqno=%u ttl=%d time=%.1f ms\n",
+		       len, inet_address(&rcvd_pkt->src_host, NULL, 0),
+		       paths[cur_path].ifname, seqno, rcvd_pkt->ttl, rtt);
+	else
+		printf("%d bytes from %s: seqno=%u ttl=%d time=%.1f ms\n",
+		       len, inet_address(&rcvd_pkt->src_host, NULL, 0),
+		       seqno, rcvd_pkt->ttl, rtt);
+}
+
+void sender_listen_loop(void)
+{
+	int i;
+
+	send_mping(0);
+
+	while (running) {
+                static char recv_packet[MAX_BUF_LEN + 1];
+                int len, segsz, off;
+
+		if ((i = path_wait()) >= 0)
+			path_select(i);
+		if (i < 0 || (len = recv_packets(recv_packet, MAX_BUF_LEN, &segsz)) < 0) {
+			if (i < 0 || errno == EINTR) {
+				burst_flush(0);
+				publish();
+				continue; /* interrupt is ok */
+			}
+                        err(1, "recvfrom() failed");
+		}
+
+		for (off = 0; off < len; off += segsz) {
+			int num = len - off < segsz ? len - off : segsz;
+
+			sender_reply(segment(recv_packet, off, num), num);
+		}
+		burst_flush(0);
+		publish();
+	}
+}
+
+/* count replies arriving within msec, only those of the current trial */
+static void search_recv(int msec)
+{
+	static char recv_packet[MAX_BUF_LEN + 1];
+	struct pollfd pfd = { .fd = sd, .events = POLLIN };
+
+	while (poll(&pfd, 1, msec) > 0) {
+		struct timeval tv, sent;
+		struct timespec now;
+		int len, segsz, off;
+
+		if ((len = recv_packets(recv_packet, MAX_BUF_LEN, &segsz)) < 0)
+			break;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		for (off = 0; off < len; off += segsz) {
+			int num = len - off < segsz ? len - off : segsz;
+
+			if (process_mping(segment(recv_packet, off, num), num, RECEIVER))
+				continue;
+
+			TIMESPEC_TO_TIMEVAL(&tv, &now);
+			packet_get_tv(&rcvd_pkt->tv, &sent);
+			subtract_timeval(&tv, &sent);
+			rtt_account(timeval_to_ms(&tv));
+			bytes_rcvd += num;
+
+			if (packet_seqno(rcvd_pkt) >= search_first)
+				search_rcvd++;
+		}
+		msec = 0;
+	}
+	publish();
+}
+
+/* probes counted by us, from replies, or by a passive receiver */
+static uint64_t search_count(void)
+{
+	struct mping_stats copy;
+
+	if (!search_counter)
+		return search_rcvd;
+
+	stats_read(search_counter, &copy);
+	return copy.rcvd;
+}
+
+/* send len byte probes at rate pps for one trial, returns number sent */
+static uint64_t search_trial(int len, int rate, unsigned int *seqno)
+{
+	uint64_t total = (uint64_t)rate * arg_trial;
+	uint64_t start, sent = 0;
+
+	start = now_ns();
+	while (running && sent < total) {
+		struct timespec ts;
+		uint64_t now, due, ns;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		now = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+		/*
+		 * Catch up with the schedule, a batch at a time.  Whole
+		 * seconds and remainder separately, (now - start) * rate
+		 * overflows for long trials at high rates.
+		 */
+		ns  = now - start;
+		due = ns / 1000000000 * rate + ns % 1000000000 * rate / 1000000000 + 1;
+		if (due > total)
+			due = total;
+		while (sent < due) {
+			packet_stamp(probe, (*seqno)++, &ts);
+			gso_queue(probe, len);
+			sent++;
+		}
+		gso_flush();
+
+		/* wait for replies until next probe is due */
+		due = start + sent / rate * 1000000000 + sent % rate * 1000000000 / rate;
+		now = now_ns();
+		search_recv(due > now ? (due - now) / 1000000 : 0);
+	}
+
+	return sent;
+}
+
+/* binary search for highest rate with loss <= arg_loss, 0 if none */
+static int search_rate(int len, unsigned int *seqno)
+{
+	int lo = arg_rate_min, hi = arg_rate_max;
+	int rate = hi, best = 0;
+
+	while (running) {
+		uint64_t base, sent, rcvd, end, now;
+		double loss;
+		int pass;
+
+		search_first = *seqno;
+		search_rcvd  = 0;
+		base = search_count();
+
+		sent = search_trial(len, rate, seqno);
+		end  = now_ms() + SEARCH_SETTLE;
+		while (running && (now = now_ms()) < end)
+			search_recv(end - now);
+		if (!running)
+			break;	/* interrupted, trial incomplete */
+
+		rcvd = search_count() - base;
+		if (rcvd > sent)
+			rcvd = sent;
+		loss = 100.0 * (sent - rcvd) / sent;
+		pass = loss <= arg_loss;
+
+		printf("%7d %10d %10.2f %10llu %10llu %6.2f%%  %s\n", len, rate,
+		       (double)rate * len * 8 / 1e6, (unsigned long long)sent,
+		       (unsigned long long)rcvd, loss, pass ? "pass" : "fail");
+		fflush(stdout);
+
+		if (pass) {
+			best = rate;
+			lo   = rate;
+		} else
+			hi   = rate;
+
+		if (hi - lo > arg_rate_res)
+			rate = lo + (hi - lo) / 2;
+		else if (!best && rate != lo)
+			rate = lo;	/* last chance, the lowest rate */
+		else
+			break;
+	}
+
+	return best;
+}
+
+void search_loop(void)
+{
+	unsigned int seqno = 0;
+	int i;
+
+	printf("Searching %d-%d pps, %d sec trials, loss <= %g%%\n",
+	       arg_rate_min, arg_rate_max, arg_trial, arg_loss);
+	printf("%7s %10s %10s %10s %10s %7s  %s\n", "bytes", "pps", "Mbit/s",
+	       "sent", "rcvd", "loss", "result");
+
+	for (i = 0; i < search_sizes && running; i++)
+		search_best[i] = search_rate(search_len(i), &seqno);
+}
+
+/* receive and reflect one datagram, or a train of GRO segments */
+static void receiver_recv(void)
+{
+	static char recv_packet[MAX_BUF_LEN + 1];
+	struct timespec now;
+	int len, segsz, off;
+
+	if ((len = recv_packets(recv_packet, MAX_BUF_LEN, &segsz)) < 0) {
+		if (errno == EINTR)
+			return; /* interrupt is ok */
+
+		err(1, "recvfrom() failed");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for (off = 0; off < len; off += segsz) {
+		int num = len - off < segsz ? len - off : segsz;
+
+		if (process_mping(segment(recv_packet, off, num), num, SENDER))
+			continue;
+
+		if (!quiet)
+			printf("Received mping from %s bytes=%d seqno=%u ttl=%d\n",
+			       inet_address(&rcvd_pkt->src_host, NULL, 0),
+			       num, packet_seqno(rcvd_pkt), rcvd_pkt->ttl);
+
+		bytes_rcvd += num;
+		if (arg_passive)
+			continue;	/* only count, e.g., for -C PID */
+
+		/* one arrival time per GRO train, unknown for each segment */
+		packet_reflect(rcvd_pkt, num, &myaddr, len > segsz ? NULL : &now);
+
+		/* send reply immediately, or batched with GSO */
+		gso_queue(rcvd_pkt, num);
+	}
+	gso_flush();
+	publish();
+}
+
+void receiver_listen_loop(void)
+{
+	printf("Listening on %s:%d\n", arg_mcaddr, arg_mcport);
+
+	while (running) {
+		int i = path_wait();
+
+		if (i < 0)
+			continue;
+
+		path_select(i);
+		receiver_recv();
+
+		/* each probe is reflected once per path */
+		if (arg_count > 0 && packets_sent >= arg_count * num_paths)
+			exit(0);
+	}
+}
+
+#ifdef HAVE_XDP
+static int ifmac(int ifindex, unsigned char *mac)
+{
+	struct ifaddrs *ifaddr, *ifa;
+	int rc = -1;
+
+	if (getifaddrs(&ifaddr) == -1)
+		return -1;
+
+	for (ifa = ifaddr; ifa; ifa = ifa->ifa_next) {
+		struct sockaddr_ll *sll = (struct sockaddr_ll *)ifa->ifa_addr;
+
+		if (!sll || sll->sll_family != AF_PACKET || sll->sll_ifindex != ifindex)
+			continue;
+
+		memcpy(mac, sll->sll_addr, 6);
+		rc = 0;
+		break;
+	}
+	freeifaddrs(ifaddr);
+
+	return rc;
+}
+
+/*
+ * Reflector with probes turned around by XDP, see xdp.bpf.c.  Packets
+ * the BPF program passes on, e.g., fragmented, are handled as usual.
+ */
+void xdp_reflector(int ifindex)
+{
+	struct mping *packet = NULL;
+	struct xdp_config cfg = {
+		.group    = ((struct sockaddr_in *)&mcaddr)->sin_addr.s_addr,
+		.addr     = ((struct sockaddr_in *)&myaddr)->sin_addr.s_addr,
+		.port     = htons(arg_mcport),
+		.ttl      = arg_ttl,
+		.min_len  = PACKET_LEGACY_LEN,
+		.off_type = offsetof(struct mping, type),
+		.off_src  = offsetof(struct mping, src_host),
+		.off_dst  = offsetof(struct mping, dest_host),
+	};
+	struct pollfd pfd = { .fd = sd, .events = POLLIN };
+	char version[sizeof(packet->version)] = { 0 };
+	uint64_t last = 0;
+
+	if (mcaddr.ss_family != AF_INET)
+		errx(1, "XDP reflector only supports IPv4");
+	if (ifmac(ifindex, cfg.mac))
+		errx(1, "failed reading MAC address of ifindex %d", ifindex);
+
+	strlencpy(version, VERSION, sizeof(version));
+	memcpy(&cfg.version, version, sizeof(cfg.version));
+	if (sizeof(packet->rx_tv.tv_sec) == 8 && sizeof(packet->rx_tv.tv_usec) == 8)
+		cfg.off_rx = offsetof(struct mping, rx_tv);
+
+	if (xdp_start(ifindex, &cfg, XDP_OBJ))
+		exit(1);
+
+	printf("Reflecting %s:%d using XDP\n", arg_mcaddr, arg_mcport);
+	while (running) {
+		uint64_t now;
+
+		if (poll(&pfd, 1, 1000) > 0)
+			receiver_recv();
+
+		xdp_stats(xdp_cnt);
+		publish();
+
+		now = now_ms();
+		if (!quiet && now - last >= 1000) {
+			printf("xdp: %llu packets received, %llu reflected, %llu invalid\n",
+			       (unsigned long long)xdp_cnt[XDP_CNT_RX],
+			       (unsigned long long)xdp_cnt[XDP_CNT_TX],
+			       (unsigned long long)xdp_cnt[XDP_CNT_INVALID]);
+			last = now;
+		}
+
+		if (arg_count > 0 && xdp_cnt[XDP_CNT_TX] + packets_sent >= (uint64_t)arg_count)
+			break;
+	}
+
+	xdp_stats(xdp_cnt);
+	xdp_stop();
+}
+#endif
+
+static void flow_add(const char *group, int port, int interval)
+{
+	struct flow *f;
+
+	f = realloc(flows, (num_flows + 1) * sizeof(struct flow));
+	if (!f)
+		err(1, "failed allocating flow table");
+	flows = f;
+
+	f = &flows[num_flows];
+	memset(f, 0, sizeof(*f));
+	if (address_inet(group, &f->group))
+		errx(1, "invalid multicast group %s", group);
+	if (f->group.ss_family == AF_INET6)
+		((struct sockaddr_in6 *)&f->group)->sin6_port = htons(port);
+	else
+		((struct sockaddr_in *)&f->group)->sin_port = htons(port);
+	f->interval = interval;
+	f->rtt_min  = 999999999.0;
+
+	num_flows++;
+}
+
+/*
+ * Flow file, one flow per line: GROUP [PORT [MSEC]]
+ * Omitted port and interval default to -p PORT and -I MSEC.
+ */
+static void flow_load(const char *file)
+{
+	char buf[256];
+	int lineno = 0;
+	FILE *fp;
+
+	fp = fopen(file, "r");
+	if (!fp)
+		err(1, "failed opening flow file %s", file);
+
+	while (fgets(buf, sizeof(buf), fp)) {
+		char group[INET_ADDRSTR_LEN];
+		int port = arg_mcport;
+		int interval = arg_interval;
+		char *ptr;
+
+		lineno++;
+		ptr = strchr(buf, '#');
+		if (ptr)
+			*ptr = 0;
+
+		if (sscanf(buf, "%63s %d %d", group, &port, &interval) < 1)
+			continue;
+		if (port <= 0 || port > 65535 || interval < 1)
+			errx(1, "%s:%d: invalid port or interval", file, lineno);
+
+		flow_add(group, port, interval);
+	}
+
+	fclose(fp);
+}
+
+static int flow_port(const struct flow *f)
+{
+	if (f->group.ss_family == AF_INET6)
+		return ntohs(((struct sockaddr_in6 *)&f->group)->sin6_port);
+
+	return ntohs(((struct sockaddr_in *)&f->group)->sin_port);
+}
+
+/* open another socket for port, bound to any address, with pktinfo */
+static int flow_socket(int family, int ifindex, int port)
+{
+	struct flow_sock *fs = &flow_socks[num_socks];
+	inet_addr_t any;
+	int on = 1;
+
+	fs->sd   = open_socket(family, ifindex);
+	fs->port = port;
+	mcast_own(fs->sd, family);
+
+	memset(&any, 0, sizeof(any));
+	any.ss_family = family;
+#ifdef AF_INET6
+	if (family == AF_INET6) {
+		((struct sockaddr_in6 *)&any)->sin6_port = htons(port);
+		if (setsockopt(fs->sd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)))
+			err(1, "Failed enabling IPV6_RECVPKTINFO");
+	} else
+#endif
+	{
+		((struct sockaddr_in *)&any)->sin_port = htons(port);
+		if (setsockopt(fs->sd, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on)))
+			err(1, "Failed enabling IP_PKTINFO");
+	}
+
+	if (bind(fs->sd, (struct sockaddr *)&any, sizeof(any)) < 0)
+		err(1, "bind() port %d failed", port);
+
+	return num_socks++;
+}
+
+/*
+ * Join each group on a socket for its port.  Linux limits the number of
+ * groups per socket, net.ipv4.igmp_max_memberships, so when a join fails
+ * with ENOBUFS, another socket for the same port is opened.
+ */
+static void flow_init(int family, int ifindex)
+{
+	int i, j;
+
+	flow_socks = calloc(num_flows, sizeof(struct flow_sock));
+	if (!flow_socks)
+		err(1, "failed allocating flow sockets");
+
+	for (i = 0; i < num_flows; i++) {
+		struct flow *f = &flows[i];
+		int port = flow_port(f);
+		struct group_req req;
+
+		if (f->group.ss_family != family)
+			errx(1, "all flows must use the same address family");
+
+		for (j = 0; j < num_socks; j++) {
+			if (flow_socks[j].port == port && !flow_socks[j].full)
+				break;
+		}
+		if (j == num_socks)
+			j = flow_socket(family, ifindex, port);
+
+		memset(&req, 0, sizeof(req));
+		req.gr_group     = f->group;
+		req.gr_interface = ifindex;
+		while (setsockopt(flow_socks[j].sd, ipproto, MCAST_JOIN_GROUP, &req, sizeof(req)) < 0) {
+			if (errno != ENOBUFS || !flow_socks[j].groups)
+				err(1, "failed joining group %s on ifindex %d",
+				    inet_address(&f->group, NULL, 0), ifindex);
+
+			dbg("socket %d full after %d groups", j, flow_socks[j].groups);
+			flow_socks[j].full = 1;
+			j = flow_socket(family, ifindex, port);
+		}
+		flow_socks[j].groups++;
+		f->sock = j;
+	}
+	dbg("%d flows on %d sockets", num_flows, num_socks);
+}
+
+/* timer wheel callback, send probe and rearm flow timer */
+static void flow_send(struct wheel_timer *t, void *arg)
+{
+	struct flow *f = (struct flow *)t;
+	size_t len = sizeof(struct mping) + arg_payload;
+	struct timespec now;
+
+	(void)arg;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	probe->dest_host = f->group;
+	probe->flow      = htonl(f - flows);
+	packet_stamp(probe, f->seqno++, &now);
+
+	if (sendto(flow_socks[f->sock].sd, probe, len, 0, (struct sockaddr *)&f->group,
+		   sizeof(f->group)) != (ssize_t)len)
+		err(1, "sendto() sent incorrect number of bytes");
+	packets_sent++;
+	bytes_sent += len;
+	f->sent++;
+
+	/* keep phase, i.e., no drift from processing delays */
+	if (arg_deadline || arg_count <= 0 || f->sent < arg_count)
+		wheel_add(&flow_wheel, t, t->expires + f->interval);
+}
+
+static void flow_reply(char *packet, int len)
+{
+	struct timeval tv, sent;
+	struct timespec now;
+	struct flow *f;
+	double rtt;
+
+	if (process_mping(packet, len, RECEIVER))
+		return;
+
+	f = &flows[packet_flow(rcvd_pkt)];
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	TIMESPEC_TO_TIMEVAL(&tv, &now);
+	packet_get_tv(&rcvd_pkt->tv, &sent);
+	subtract_timeval(&tv, &sent);
+	rtt = timeval_to_ms(&tv);
+	bytes_rcvd += len;
+
+	rtt_account(rtt);
+
+	f->rcvd++;
+	f->rtt_total += rtt;
+	if (rtt > f->rtt_max)
+		f->rtt_max = rtt;
+	if (rtt < f->rtt_min)
+		f->rtt_min = rtt;
+
+	if (!quiet) {
+		char buf[INET_ADDRSTR_LEN];
+
+		printf("%d bytes from %s: group=%s seqno=%u ttl=%d time=%.1f ms\n",
+		       len, inet_address(&rcvd_pkt->src_host, NULL, 0),
+		       inet_address(&f->group, buf, sizeof(buf)), packet_seqno(rcvd_pkt),
+		       rcvd_pkt->ttl, rtt);
+	}
+}
+
+/* reflect to the group the probe was sent to, from IP_PKTINFO */
+static void flow_reflect(struct flow_sock *fs, char *packet, int len, inet_addr_t *group)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (process_mping(packet, len, SENDER))
+		return;
+
+	if (!quiet) {
+		char buf[INET_ADDRSTR_LEN];
+
+		printf("Received mping from %s group=%s bytes=%d seqno=%u ttl=%d\n",
+		       inet_address(&rcvd_pkt->src_host, NULL, 0),
+		       inet_address(group, buf, sizeof(buf)), len, packet_seqno(rcvd_pkt),
+		       rcvd_pkt->ttl);
+	}
+
+	packet_reflect(rcvd_pkt, len, &myaddr, &now);
+
+	if (sendto(fs->sd, rcvd_pkt, len, 0, (struct sockaddr *)group, sizeof(*group)) != len)
+		err(1, "sendto() sent incorrect number of bytes");
+	packets_sent++;
+	bytes_sent += len;
+}
+
+static int flow_recv(struct flow_sock *fs, char *buf, size_t len, inet_addr_t *group)
+{
+	char control[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len  = len
+	};
+	struct msghdr msg = {
+		.msg_iov        = &iov,
+		.msg_iovlen     = 1,
+		.msg_control    = control,
+		.msg_controllen = sizeof(control)
+	};
+	struct cmsghdr *cmsg;
+	ssize_t num;
+
+	num = recvmsg(fs->sd, &msg, 0);
+	if (num < 0)
+		return -1;
+
+	memset(group, 0, sizeof(*group));
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+#ifdef AF_INET6
+		if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
+			struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)group;
+			struct in6_pktinfo pi;
+
+			memcpy(&pi, CMSG_DATA(cmsg), sizeof(pi));
+			sin6->sin6_family = AF_INET6;
+			sin6->sin6_addr   = pi.ipi6_addr;
+			sin6->sin6_port   = htons(fs->port);
+		}
+#endif
+		if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+			struct sockaddr_in *sin = (struct sockaddr_in *)group;
+			struct in_pktinfo pi;
+
+			memcpy(&pi, CMSG_DATA(cmsg), sizeof(pi));
+			sin->sin_family = AF_INET;
+			sin->sin_addr   = pi.ipi_addr;
+			sin->sin_port   = htons(fs->port);
+		}
+	}
+
+	return num;
+}
+
+static void flow_expire(void)
+{
+	wheel_run(&flow_wheel, now_ms(), flow_send, NULL);
+}
+
+/*
+ * Sender, or reflector, main loop for flow mode.  Timers are run from
+ * the loop, not SIGALRM, sleeping in poll() until the next timer.
+ */
+void flow_loop(int mode)
+{
+	static char buf[MAX_BUF_LEN + 1] __attribute__((aligned(16)));
+	struct pollfd *pfd;
+	uint64_t now, end = 0;
+	int i;
+
+	pfd = calloc(num_socks, sizeof(struct pollfd));
+	if (!pfd)
+		err(1, "failed allocating poll set");
+	for (i = 0; i < num_socks; i++) {
+		pfd[i].fd     = flow_socks[i].sd;
+		pfd[i].events = POLLIN;
+	}
+
+	now = now_ms();
+	wheel_init(&flow_wheel, now);
+	if (mode == 's') {
+		/* randomize phase so flows with same interval don't synchronize */
+		srandom(now ^ pid);
+		for (i = 0; i < num_flows; i++)
+			wheel_add(&flow_wheel, &flows[i].timer, now + random() % flows[i].interval);
+		if (arg_deadline)
+			end = now + arg_deadline * 1000;
+	}
+
+	while (running) {
+		int64_t next = wheel_next(&flow_wheel);
+		int timeout = -1;
+
+		now = now_ms();
+		if (mode == 's') {
+			/* all flows done, wait for stragglers */
+			if (!end && !flow_wheel.pending)
+				end = now + arg_timeout * 1000;
+			if (end && now >= end)
+				break;
+			if (arg_deadline && arg_count > 0 && packets_rcvd >= arg_count * num_flows)
+				break;
+			if (end)
+				timeout = end - now;
+		}
+		if (next >= 0 && (timeout < 0 || next < timeout))
+			timeout = next;
+
+		if (poll(pfd, num_socks, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			err(1, "poll() failed");
+		}
+
+		for (i = 0; i < num_socks; i++) {
+			inet_addr_t group;
+			int len;
+
+			if (!(pfd[i].revents & POLLIN))
+				continue;
+
+			len = flow_recv(&flow_socks[i], buf, MAX_BUF_LEN, &group);
+			if (len < 0) {
+				if (errno == EINTR)
+					continue;
+				err(1, "recvmsg() failed");
+			}
+
+			if (mode == 's')
+				flow_reply(buf, len);
+			else if (group.ss_family)
+				flow_reflect(&flow_socks[i], buf, len, &group);
+		}
+
+		if (mode == 's')
+			flow_expire();
+		publish();
+
+		if (mode != 's' && arg_count > 0 && packets_sent >= arg_count)
+			break;
+	}
+
+	free(pfd);
+}
+
+static int flow_cleanup(int sender)
+{
+	int i;
+
+	for (i = 0; i < num_socks; i++)
+		close(flow_socks[i].sd);
+
+	printf("\n--- %d flows mping statistics ---\n", num_flows);
+	printf("%d packets transmitted, %d packets received\n", packets_sent, packets_rcvd);
+	if (packets_rcvd == 0 || rtt_min > rtt_max)
+		printf("round-trip min/avg/max = NA/NA/NA ms\n");
+	else
+		printf("round-trip min/avg/max = %.3f/%.3f/%.3f ms\n",
+		       rtt_min, (rtt_total / packets_rcvd), rtt_max);
+
+	if (!sender)
+		return 0;
+
+	printf("%-39s %5s %6s %7s %7s %6s %9s %9s %9s\n", "group", "port", "msec",
+	       "sent", "rcvd", "loss", "min", "avg", "max");
+	for (i = 0; i < num_flows; i++) {
+		struct flow *f = &flows[i];
+
+		printf("%-39s %5d %6d %7d %7d %5.1f%%", inet_address(&f->group, NULL, 0),
+		       flow_port(f), f->interval, f->sent, f->rcvd,
+		       f->sent ? 100.0 * (f->sent - f->rcvd) / f->sent : 0.0);
+		if (f->rcvd)
+			printf(" %9.3f %9.3f %9.3f\n", f->rtt_min,
+			       f->rtt_total / f->rcvd, f->rtt_max);
+		else
+			printf(" %9s %9s %9s\n", "NA", "NA", "NA");
+	}
+
+	if (arg_count > 0 && arg_count * num_flows > packets_rcvd)
+		return 1;
+
+	return 0;
+}
+
+int usage(void)
 {
 	fprintf(stderr,
 		"Usage:\n"
-                "  mping [-" OPTSTR "dhqrsv] [-b BYTES] [-c COUNT] [-i IFNAME] [-p PORT] [-t TTL]\n"
-		"        [-w SEC] [-W SEC] [GROUP]\n"
+                "  mping [-" OPTSTR "dghnPqrsvx] [-b BYTES] [-B NUM] [-c COUNT] [-C PID] [-f FILE]\n"
+		"        [-i IFNAME] [-I MSEC] [-L PERCENT] [-p PORT] [-R MIN:MAX[:RES]] [-t TTL]\n"
+		"        [-T SEC] [-w SEC] [-W SEC] [-z MIN:MAX[:STEP]] [GROUP [GROUP ...]]\n"
+		"  mping [-c COUNT] [-I MSEC] -S PID\n"
                 "\n"
 		"Options:\n"
 #ifdef AF_INET6
 		"  -6          Use IPv6 instead of IPv4, see below for defaults\n"
 #endif
 		"  -b BYTES    Extra payload bytes (empty data), default: 0\n"
+		"  -B NUM      Burst mode, send NUM back-to-back packets every interval\n"
                 "  -c COUNT    Stop after sending/receiving COUNT packets\n"
+		"  -C PID      Count search trials at passive receiver PID, started with -n -P\n"
                 "  -d          Debug messages\n"
+		"  -f FILE     Flow mode, probe all groups in FILE: GROUP [PORT [MSEC]]\n"
+		"  -g          Use UDP GSO/GRO offload, send bursts in one syscall\n"
 		"  -h          This help text\n"
-		"  -i IFNAME   Interface to use for sending/receiving\n"
+		"  -i IFNAME   Interface to use for sending/receiving, repeat to probe\n"
+		"              several paths at once, with statistics and skew per path\n"
+		"  -I MSEC     Interval between packets, or bursts, default 1000\n"
+		"  -L PERCENT  Max loss for a passed search trial, default 0\n"
+		"  -n          Passive receiver, count but do not reflect probes\n"
 		"  -p PORT     Multicast port to listen/send to, default %d\n"
+		"  -P          Publish live statistics in shared memory, /dev/shm/mping-PID\n"
                 "  -q          Quiet output, only startup and and summary lines\n"
 		"  -r          Receiver/reflector mode, default\n"
+		"  -R MIN:MAX[:RES]\n"
+		"              Throughput search, find highest rate in pps with loss at most -L,\n"
+		"              per payload size with -z, resolution default 1%% of range\n"
                 "  -s          Sender mode\n"
+		"  -S PID      Show live statistics of mping PID, started with -P\n"
 		"  -t TTL      Multicast time to live to send, IPv6 hops, default %d\n"
+		"  -T SEC      Duration of each search trial, default %d\n"
 		"  -v          Show program version and contact information\n"
                 "  -w DEADLINE Timeout before exiting, waiting for COUNT replies\n"
                 "  -W TIMEOUT  Time to wait for a response, in seconds, default 5\n"
+		"  -x          Reflector mode using XDP, IPv4 only, requires root\n"
+		"  -z MIN:MAX[:STEP]\n"
+		"              Sweep payload size from MIN to MAX bytes, COUNT packets per\n"
+		"              step, default 10, and report loss and latency per size\n"
                 "\n"
                 "Defaults to use multicast group %s, UDP dst port %d, unless -6 in which\n"
 		"case a multicast group %s is used.  When a group argument is given, the\n"
 		"address family is chosen from that.  The selected outbound interface is chosen\n"
-                "by querying the routing table, unless -i IFNAME\n",
-                MC_PORT_DEFAULT, MC_TTL_DEFAULT, MC_GROUP_DEFAULT, MC_PORT_DEFAULT,
+                "by querying the routing table, unless -i IFNAME.  With more than one group\n"
+		"argument, or -f FILE, each group is a flow with its own sequence numbers and\n"
+		"statistics, using -p PORT and -I MSEC unless set in FILE\n",
+                MC_PORT_DEFAULT, MC_TTL_DEFAULT, SEARCH_TRIAL, MC_GROUP_DEFAULT, MC_PORT_DEFAULT,
 		MC_GROUP_INET6);
 
 	return 0;
@@ -743,18 +2341,23 @@ int main(int argc, char **argv)
 	int family = AF_INET;
 	char *iface = NULL;
         inet_addr_t addr;
-	char ifname[16];
         int mode = 'r';
 	int ifindex;
-	int c;
+	int c, i;
 
-	while ((c = getopt(argc, argv, OPTSTR "b:c:dh?i:p:qrst:vW:w:")) != -1) {
+	while ((c = getopt(argc, argv, OPTSTR "b:B:c:C:df:gh?i:I:L:np:PqrR:sS:t:T:vW:w:xz:")) != -1) {
 		switch (c) {
 		case 'b':
 			arg_payload = atoi(optarg);
 			if (arg_payload < 0 || arg_payload > (int)MAX_PAYLOAD)
 				errx(1, "Invalid or too large payload, max %zu", MAX_PAYLOAD);
 			break;
+
+		case 'B':
+			arg_burst = atoi(optarg);
+			if (arg_burst < 1 || arg_burst > MAX_BURST)
+				errx(1, "Invalid burst size, 1-%d", MAX_BURST);
+			break;
 #ifdef AF_INET6
 		case '6':
 			family = AF_INET6;
@@ -765,19 +2368,55 @@ int main(int argc, char **argv)
                         arg_count = atoi(optarg);
                         break;
 
+		case 'C':
+			arg_counter = atoi(optarg);
+			if (arg_counter <= 0)
+				errx(1, "Invalid PID");
+			break;
+
 		case 'd':
 			debug = 1;
 			break;
 
+		case 'f':
+			arg_flows = optarg;
+			break;
+
+		case 'g':
+			arg_gso = 1;
+			break;
+
 		case 'i':
-			strlencpy(ifname, optarg, sizeof(ifname));
-			iface = ifname;
+			if (num_ifaces >= MAX_PATHS)
+				errx(1, "Too many interfaces, max %d", MAX_PATHS);
+			arg_ifaces[num_ifaces++] = optarg;
+			iface = arg_ifaces[0];
+			break;
+
+		case 'I':
+			arg_interval = atoi(optarg);
+			if (arg_interval < 1)
+				errx(1, "Invalid interval, min 1 msec");
+			break;
+
+		case 'L':
+			arg_loss = atof(optarg);
+			if (arg_loss < 0 || arg_loss > 100)
+				errx(1, "Invalid loss threshold, 0-100 %%");
+			break;
+
+		case 'n':
+			arg_passive = 1;
 			break;
 
 		case 'p':
 			arg_mcport = atoi(optarg);
 			break;
 
+		case 'P':
+			arg_publish = 1;
+			break;
+
                 case 'q':
                         quiet = 1;
                         break;
@@ -786,14 +2425,33 @@ int main(int argc, char **argv)
                         mode = 'r';
 			break;
 
+		case 'R':
+			if (sscanf(optarg, "%d:%d:%d", &arg_rate_min, &arg_rate_max, &arg_rate_res) < 2)
+				errx(1, "Invalid throughput search, use MIN:MAX[:RES]");
+			if (arg_rate_min < 1 || arg_rate_min > arg_rate_max || arg_rate_max > 10000000)
+				errx(1, "Invalid throughput search range, 1-10000000 pps");
+			break;
+
 		case 's':
                         mode = 's';
 			break;
 
+		case 'S':
+			arg_show = atoi(optarg);
+			if (arg_show <= 0)
+				errx(1, "Invalid PID");
+			break;
+
 		case 't':
 			arg_ttl = atoi(optarg);
 			break;
 
+		case 'T':
+			arg_trial = atoi(optarg);
+			if (arg_trial < 1)
+				errx(1, "Invalid trial time, min 1 sec");
+			break;
+
 		case 'v':
 			printf("mping version %s\n"
                                "\n"
@@ -809,6 +2467,21 @@ int main(int argc, char **argv)
                         arg_timeout = atoi(optarg);
                         break;
 
+		case 'x':
+#ifdef HAVE_XDP
+			arg_xdp = 1;
+			break;
+#else
+			errx(1, "XDP reflector not supported, rebuild with: make XDP=1");
+#endif
+
+		case 'z':
+			if (sscanf(optarg, "%d:%d:%d", &arg_sweep_min, &arg_sweep_max, &arg_sweep_step) < 2)
+				errx(1, "Invalid payload sweep, use MIN:MAX[:STEP]");
+			if (arg_sweep_min < 0 || arg_sweep_max > (int)MAX_PAYLOAD || arg_sweep_min > arg_sweep_max)
+				errx(1, "Invalid payload sweep range, max %zu", MAX_PAYLOAD);
+			break;
+
 		case '?':
 		case 'h':
 		default:
@@ -823,6 +2496,82 @@ int main(int argc, char **argv)
                 strlencpy(arg_mcaddr, MC_GROUP_INET6, sizeof(arg_mcaddr));
 #endif
 
+	packet_version(VERSION);
+	if (arg_show) {
+		sig(SIGINT, clean_exit);
+		return stats_show(arg_show, arg_count, arg_interval, &running);
+	}
+	if (arg_xdp && mode == 's')
+		errx(1, "XDP mode is only for the reflector");
+	if (arg_publish || arg_xdp) {
+		sig(SIGINT, clean_exit);
+		sig(SIGTERM, clean_exit);
+	}
+
+	if (arg_flows)
+		flow_load(arg_flows);
+	if (arg_flows || argc - optind > 1) {
+		for (i = optind; i < argc; i++)
+			flow_add(argv[i], arg_mcport, arg_interval);
+		if (!num_flows)
+			errx(1, "no flows in %s", arg_flows);
+		if (arg_burst > 1 || arg_sweep_max || arg_gso || arg_xdp || num_ifaces > 1 || arg_rate_max)
+			errx(1, "Flow mode cannot be combined with burst, sweep, GSO, XDP, search, or multiple interfaces");
+
+		pid = getpid();
+		family = flows[0].group.ss_family;
+		ifindex = ifinfo(iface, &addr, family);
+		if (ifindex <= 0)
+			exit(1);
+
+		myaddr = addr;
+		flow_init(family, ifindex);
+		if (arg_publish) {
+			char buf[INET_ADDRSTR_LEN];
+
+			snprintf(buf, sizeof(buf), "%d flows", num_flows);
+			shm = stats_create(mode, buf);
+		}
+
+		if (mode == 's') {
+			printf("MPING %d flows (ttl %d)\n", num_flows, arg_ttl);
+			sig(SIGINT, clean_exit);
+			init_probe();
+		} else
+			printf("Listening on %d flows\n", num_flows);
+
+		flow_loop(mode);
+
+		return flow_cleanup(mode == 's');
+	}
+
+	if (num_ifaces > 1 && (arg_burst > 1 || arg_sweep_max || arg_xdp))
+		errx(1, "Multiple interfaces cannot be combined with burst, sweep, or XDP");
+
+	if (arg_rate_max) {
+		if (mode != 's')
+			errx(1, "Throughput search is only for the sender");
+		if (arg_burst > 1 || arg_deadline || num_ifaces > 1)
+			errx(1, "Throughput search cannot be combined with burst, deadline, or multiple interfaces");
+		if (arg_rate_res <= 0)
+			arg_rate_res = (arg_rate_max - arg_rate_min) / 100;
+		if (arg_rate_res <= 0)
+			arg_rate_res = 1;
+		if (arg_counter)
+			search_counter = stats_open(arg_counter);
+		if (arg_sweep_max)
+			init_sweep();
+
+		search_sizes = sweep_steps ? sweep_steps : 1;
+		search_best  = calloc(search_sizes, sizeof(int));
+		if (!search_best)
+			err(1, "failed allocating search table");
+	} else if (arg_sweep_max) {
+		if (arg_deadline)
+			errx(1, "Payload sweep cannot be combined with deadline mode");
+		arg_count = init_sweep();
+	}
+
 	if (address_inet(arg_mcaddr, &mcaddr))
 		errx(1, "invalid multicast group");
 
@@ -830,17 +2579,37 @@ int main(int argc, char **argv)
 		family = mcaddr.ss_family;
 
 	pid = getpid();
-	ifindex = ifinfo(iface, &addr, family);
-	if (ifindex <= 0)
-		exit(1);
 
 	if (debug) {
 		struct mping packet;
 		printf("tv_sec/tv_usec size: %zu/%zu\n", sizeof(packet.tv.tv_sec), sizeof(packet.tv.tv_usec));
 	}
 
-	init_socket(mcaddr.ss_family, ifindex);
-	myaddr = addr;
+	/* one path per -i, or the default interface */
+	do {
+		struct path *p = &paths[num_paths];
+
+		ifindex = ifinfo(arg_ifaces[num_paths], &addr, family);
+		if (ifindex <= 0)
+			exit(1);
+
+		init_socket(mcaddr.ss_family, ifindex);
+		init_buffers(mode == 's');
+		if (arg_gso)
+			init_offload();
+
+		p->sd      = sd;
+		p->gr      = gr;
+		p->addr    = addr;
+		p->ifindex = ifindex;
+		p->rtt_min = 999999999.0;
+		if_indextoname(ifindex, p->ifname);
+	} while (++num_paths < num_ifaces);
+	path_select(0);
+	ifindex = paths[0].ifindex;
+
+	if (arg_publish)
+		shm = stats_create(mode, arg_mcaddr);
 
 	if (mode == 's') {
 		struct timespec now;
@@ -850,10 +2619,19 @@ int main(int argc, char **argv)
 		printf("MPING %s:%d (ttl %d)\n", arg_mcaddr, arg_mcport, arg_ttl);
 
 		sig(SIGINT, clean_exit);
-		sig(SIGALRM, send_mping);
-
-		sender_listen_loop();
-	} else
+		init_probe();
+		if (search_sizes)
+			search_loop();
+		else {
+			sig(SIGALRM, send_mping);
+			sender_listen_loop();
+		}
+	}
+#ifdef HAVE_XDP
+	else if (arg_xdp)
+		xdp_reflector(ifindex);
+#endif
+	else
 		receiver_listen_loop();
 
 	return cleanup();
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "packet.h"
+
+static uint32_t tag;			/* version[], as one fixed-offset load */
+
+/* set version for packet_init() and packet_check(), max 3 chars + NUL */
+void packet_version(const char *version)
+{
+	char buf[sizeof(tag)] = { 0 };
+
+	strncpy(buf, version, sizeof(buf) - 1);
+	memcpy(&tag, buf, sizeof(tag));
+}
+
+/*
+ * Build probe template once, the sender then only patches seqno and
+ * timestamps, see packet_stamp(), and burst, flow, or path fields when
+ * used.  The payload, up to len, stays zero.
+ */
+void packet_init(struct mping *tmpl, size_t len, unsigned char ttl,
+		 const inet_addr_t *src, const inet_addr_t *group, pid_t pid)
+{
+	memset(tmpl, 0, len);
+	memcpy(tmpl->version, &tag, sizeof(tag));
+	tmpl->type      = SENDER;
+	tmpl->ttl       = ttl;
+	tmpl->src_host  = *src;
+	tmpl->dest_host = *group;
+	tmpl->pid       = pid;
+}
+
+/* validate header of received packet, read-only */
+int packet_check(const void *buf, size_t len, unsigned char type)
+{
+	const struct mping *p = buf;
+	uint32_t version;
+
+	if (len < PACKET_LEGACY_LEN)
+		return PACKET_SHORT;
+
+	memcpy(&version, p->version, sizeof(version));
+	if (version != tag)
+		return PACKET_VERSION;
+
+	if (p->type != type)
+		return PACKET_TYPE;
+
+	/* probes may be legacy, but our own replies are always complete */
+	if (type == RECEIVER && len < sizeof(struct mping))
+		return PACKET_SHORT;
+
+	return PACKET_OK;
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MPING_PACKET_H_
+#define MPING_PACKET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#if __BIG_ENDIAN__
+# define htonll(x) (x)
+# define ntohll(x) (x)
+#else
+# define htonll(x) (((uint64_t)htonl((x) & 0xFFFFFFFF) << 32) | htonl((x) >> 32))
+# define ntohll(x) (((uint64_t)ntohl((x) & 0xFFFFFFFF) << 32) | ntohl((x) >> 32))
+#endif
+
+#define SENDER           's'
+#define RECEIVER         'r'
+
+typedef struct sockaddr_storage inet_addr_t;
+
+/*
+ * Wire format, all fields in network byte order except pid, which is
+ * only compared by the sender itself, and the addresses.  Received
+ * packets are never converted in place, fields are read with the
+ * packet_*() accessors below, so the reflector only has to patch the
+ * few fields it changes before sending the same buffer back.
+ */
+struct mping {
+	char            version[4];
+
+	unsigned char   type;
+	unsigned char   ttl;
+	unsigned char   path;		/* multi-path: index of -i interface */
+
+	inet_addr_t     src_host;
+	inet_addr_t     dest_host;
+
+	unsigned int    seq_no;
+	pid_t           pid;
+
+	struct timeval  tv;
+
+	unsigned int    burst_no;	/* burst mode: burst number */
+	unsigned short  burst_idx;	/*   index within burst */
+	unsigned short  burst_len;	/*   probes in burst */
+	struct timeval  rx_tv;		/*   arrival time at reflector */
+
+	unsigned int    flow;		/* flow mode: index in flow table */
+
+	char            payload[0];	/* optional payload */
+};
+
+/*
+ * A v2.1 header ends before the burst fields, such probes are reflected
+ * as-is, with all extension fields absent.  Replies must be complete.
+ */
+#define PACKET_LEGACY_LEN  offsetof(struct mping, burst_no)
+
+enum {
+	PACKET_OK = 0,
+	PACKET_SHORT,
+	PACKET_VERSION,
+	PACKET_TYPE,
+};
+
+static inline unsigned int packet_seqno(const struct mping *p)
+{
+	return ntohl(p->seq_no);
+}
+
+static inline unsigned int packet_burst_no(const struct mping *p)
+{
+	return ntohl(p->burst_no);
+}
+
+static inline unsigned int packet_burst_idx(const struct mping *p)
+{
+	return ntohs(p->burst_idx);
+}
+
+static inline unsigned int packet_burst_len(const struct mping *p)
+{
+	return ntohs(p->burst_len);
+}
+
+static inline unsigned int packet_flow(const struct mping *p)
+{
+	return ntohl(p->flow);
+}
+
+/* read timestamp from wire, tv or rx_tv */
+static inline void packet_get_tv(const struct timeval *wire, struct timeval *tv)
+{
+	if (sizeof(tv->tv_sec) == 8)
+		tv->tv_sec  = ntohll(wire->tv_sec);
+	else
+		tv->tv_sec  = ntohl(wire->tv_sec);
+
+	if (sizeof(tv->tv_usec) == 8)
+		tv->tv_usec = ntohll(wire->tv_usec);
+	else
+		tv->tv_usec = ntohl(wire->tv_usec);
+}
+
+/* write timestamp to wire */
+static inline void packet_put_tv(struct timeval *wire, const struct timespec *ts)
+{
+	struct timeval tv = { ts->tv_sec, ts->tv_nsec / 1000 };
+
+	if (sizeof(tv.tv_sec) == 8)
+		wire->tv_sec  = htonll(tv.tv_sec);
+	else
+		wire->tv_sec  = htonl(tv.tv_sec);
+
+	if (sizeof(tv.tv_usec) == 8)
+		wire->tv_usec = htonll(tv.tv_usec);
+	else
+		wire->tv_usec = htonl(tv.tv_usec);
+}
+
+/* patch the per-probe fields of a template from packet_init() */
+static inline void packet_stamp(struct mping *p, unsigned int seqno, const struct timespec *now)
+{
+	p->seq_no = htonl(seqno);
+	packet_put_tv(&p->tv, now);
+}
+
+static inline void packet_burst(struct mping *p, unsigned int no, unsigned int idx, unsigned int len)
+{
+	p->burst_no  = htonl(no);
+	p->burst_idx = htons(idx);
+	p->burst_len = htons(len);
+}
+
+/*
+ * Turn a validated probe around, in place, ready to be sent back.  If
+ * the arrival time is unknown, now is NULL, rx_tv is sent as zero.
+ */
+static inline void packet_reflect(struct mping *p, size_t len, const inet_addr_t *addr,
+				  const struct timespec *now)
+{
+	static const struct timespec unknown = { 0 };
+
+	p->type      = RECEIVER;
+	p->dest_host = p->src_host;
+	p->src_host  = *addr;
+	if (len >= sizeof(struct mping))
+		packet_put_tv(&p->rx_tv, now ? now : &unknown);
+}
+
+void packet_version (const char *version);
+void packet_init    (struct mping *tmpl, size_t len, unsigned char ttl,
+		     const inet_addr_t *src, const inet_addr_t *group, pid_t pid);
+int  packet_check   (const void *buf, size_t len, unsigned char type);
+
+#endif /* MPING_PACKET_H_ */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
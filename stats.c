@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+
+static struct mping_stats *stats;
+static char name[32];
+
+/* create and map segment, removed again at exit by stats_remove() */
+struct mping_stats *stats_create(char mode, const char *group)
+{
+	int fd;
+
+	snprintf(name, sizeof(name), STATS_NAME, getpid());
+	fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		err(1, "failed creating shared memory %s", name);
+
+	if (ftruncate(fd, sizeof(*stats)))
+		err(1, "failed sizing shared memory %s", name);
+
+	stats = mmap(NULL, sizeof(*stats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (stats == MAP_FAILED)
+		err(1, "failed mapping shared memory %s", name);
+
+	stats->version = STATS_VERSION;
+	stats->pid     = getpid();
+	stats->mode    = mode;
+	strncpy(stats->group, group, sizeof(stats->group) - 1);
+	atexit(stats_remove);
+
+	return stats;
+}
+
+void stats_remove(void)
+{
+	if (!stats)
+		return;
+
+	munmap(stats, sizeof(*stats));
+	shm_unlink(name);
+	stats = NULL;
+}
+
+/* map segment of another mping read-only */
+const struct mping_stats *stats_open(pid_t pid)
+{
+	struct mping_stats *st;
+	char path[32];
+	int fd;
+
+	snprintf(path, sizeof(path), STATS_NAME, pid);
+	fd = shm_open(path, O_RDONLY, 0);
+	if (fd < 0)
+		err(1, "no statistics for pid %d, was it started with -P?", pid);
+
+	st = mmap(NULL, sizeof(*st), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (st == MAP_FAILED)
+		err(1, "failed mapping shared memory %s", path);
+	if (st->version != STATS_VERSION)
+		errx(1, "unsupported statistics version %u", st->version);
+
+	return st;
+}
+
+/* consistent copy of a live segment, retry while the writer is busy */
+void stats_read(const struct mping_stats *st, struct mping_stats *copy)
+{
+	uint32_t seq;
+
+	do {
+		while ((seq = __atomic_load_n(&st->seq, __ATOMIC_ACQUIRE)) & 1)
+			;
+		memcpy(copy, st, sizeof(*copy));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&st->seq, __ATOMIC_RELAXED) != seq);
+}
+
+static void show_hist(const struct mping_stats *st)
+{
+	uint64_t max = 0;
+	int i, first = -1, last = 0;
+
+	for (i = 0; i < STATS_BUCKETS; i++) {
+		if (!st->hist[i])
+			continue;
+		if (first == -1)
+			first = i;
+		if (st->hist[i] > max)
+			max = st->hist[i];
+		last = i;
+	}
+	if (first == -1)
+		return;
+
+	printf("\nround-trip histogram:\n");
+	for (i = first; i <= last; i++) {
+		int bar = st->hist[i] * 40 / max;
+
+		printf("  < %8lu usec %10llu |%.*s\n", 1UL << i,
+		       (unsigned long long)st->hist[i], bar,
+		       "****************************************");
+	}
+}
+
+/* mping -S PID, poll segment of another mping every interval msec */
+int stats_show(pid_t pid, int count, int interval, volatile sig_atomic_t *running)
+{
+	struct timespec ts = { interval / 1000, (interval % 1000) * 1000000 };
+	const struct mping_stats *st;
+	struct mping_stats copy;
+	int num = 0;
+
+	st = stats_open(pid);
+
+	printf("MPING %d %s %s\n", st->pid, st->mode == 's' ? "sender" : "reflector", st->group);
+	while (*running) {
+		stats_read(st, &copy);
+
+		printf("%llu packets transmitted, %llu packets received",
+		       (unsigned long long)copy.sent, (unsigned long long)copy.rcvd);
+		if (copy.rtt_max > 0)
+			printf(", round-trip min/avg/max = %.3f/%.3f/%.3f ms",
+			       copy.rtt_min, copy.rtt_total / copy.rcvd, copy.rtt_max);
+		printf("\n");
+
+		if (count > 0 && ++num >= count)
+			break;
+		nanosleep(&ts, NULL);
+	}
+
+	show_hist(&copy);
+	munmap((void *)st, sizeof(*st));
+
+	return 0;
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
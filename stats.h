@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MPING_STATS_H_
+#define MPING_STATS_H_
+
+#include <signal.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Live statistics, published in shared memory, /dev/shm/mping-PID, for
+ * external tools.  The counters are protected by a seqlock: the writer
+ * increments seq before (odd) and after (even) each update, a reader
+ * retries until it sees the same even seq before and after its copy.
+ */
+#define STATS_NAME     "/mping-%d"
+#define STATS_VERSION  1
+#define STATS_BUCKETS  24		/* log2(usec), up to ~8 sec */
+#define CACHELINE      64
+
+struct mping_stats {
+	/* written once at startup */
+	uint32_t        version;
+	int32_t         pid;
+	char            mode;		/* 's' sender, 'r' reflector */
+	char            group[64];
+
+	/* seqlock protected, own cache line(s) */
+	uint32_t        seq __attribute__((aligned(CACHELINE)));
+	uint64_t        updated;	/* CLOCK_MONOTONIC, msec */
+	uint64_t        sent;
+	uint64_t        rcvd;
+	uint64_t        bytes_sent;
+	uint64_t        bytes_rcvd;
+	double          rtt_min;	/* msec */
+	double          rtt_max;
+	double          rtt_total;
+	uint64_t        hist[STATS_BUCKETS];
+} __attribute__((aligned(CACHELINE)));
+
+static inline void stats_begin(struct mping_stats *st)
+{
+	__atomic_store_n(&st->seq, st->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void stats_end(struct mping_stats *st)
+{
+	__atomic_store_n(&st->seq, st->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* histogram bucket for rtt in msec, bucket N is [2^(N-1), 2^N) usec */
+static inline int stats_bucket(double rtt)
+{
+	unsigned long usec = rtt * 1000;
+	int i = 0;
+
+	while (usec && i < STATS_BUCKETS - 1) {
+		usec >>= 1;
+		i++;
+	}
+
+	return i;
+}
+
+struct mping_stats *stats_create (char mode, const char *group);
+void                stats_remove (void);
+
+const struct mping_stats *stats_open (pid_t pid);
+void                stats_read   (const struct mping_stats *st, struct mping_stats *copy);
+int                 stats_show   (pid_t pid, int count, int interval,
+				  volatile sig_atomic_t *running);
+
+#endif /* MPING_STATS_H_ */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
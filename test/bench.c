@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Microbenchmark of the packet hot path, ns per packet to build a probe
+ * from the template, to parse a reply, and to reflect a probe.  As a
+ * baseline, the same is measured for the old v2.1 code path: memset()
+ * and fill in every probe, and convert the whole header in place with
+ * hton/ntoh on send and receive.  Run with: make bench [N=ITERATIONS]
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* For TIMESPEC_TO_TIMEVAL() in GLIBC */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "../packet.h"
+
+#define ITERATIONS  10000000
+#define barrier(p)  __asm__ __volatile__("" : : "r"(p) : "memory")
+
+static char buf[2048] __attribute__((aligned(16)));
+
+static uint64_t now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void report(const char *name, uint64_t start, long num)
+{
+	printf("%-14s %8.2f ns/packet\n", name, (double)(now_ns() - start) / num);
+}
+
+/*
+ * Legacy code path, as in mping before the packet_*() accessors
+ */
+static void legacy_timeval(struct timeval *tv)
+{
+	if (sizeof(tv->tv_sec) == 8)
+		tv->tv_sec  = htonll(tv->tv_sec);
+	else
+		tv->tv_sec  = htonl(tv->tv_sec);
+
+	if (sizeof(tv->tv_usec) == 8)
+		tv->tv_usec = htonll(tv->tv_usec);
+	else
+		tv->tv_usec = htonl(tv->tv_usec);
+}
+
+/* byte swap is its own inverse, so this is both hton and ntoh */
+static void legacy_swap(struct mping *p)
+{
+	p->seq_no    = htonl(p->seq_no);
+	p->burst_no  = htonl(p->burst_no);
+	p->burst_idx = htons(p->burst_idx);
+	p->burst_len = htons(p->burst_len);
+	p->flow      = htonl(p->flow);
+
+	legacy_timeval(&p->tv);
+	legacy_timeval(&p->rx_tv);
+}
+
+static void legacy_init(struct mping *p, size_t len, struct timespec *now,
+			inet_addr_t *group, unsigned int seqno)
+{
+	memset(p, 0, len);
+	TIMESPEC_TO_TIMEVAL(&p->tv, now);
+	strncpy(p->version, "2.1", sizeof(p->version));
+	p->type      = SENDER;
+	p->ttl       = 1;
+	p->src_host  = *group;
+	p->dest_host = *group;
+	p->seq_no    = seqno;
+	p->pid       = 4711;
+}
+
+static int legacy_check(struct mping *p, int len, unsigned char type)
+{
+	if (len < (int)sizeof(struct mping))
+		return -1;
+
+	legacy_swap(p);
+	if (strcmp(p->version, "2.1"))
+		return -1;
+	if (p->type != type)
+		return -1;
+
+	return 0;
+}
+
+static unsigned int legacy(struct mping *p, long num)
+{
+	struct timespec ts = { 0 };
+	inet_addr_t addr = { 0 };
+	unsigned int sum = 0;
+	uint64_t start;
+	long i;
+
+	start = now_ns();
+	for (i = 0; i < num; i++) {
+		ts.tv_nsec = i & 0x3fffffff;
+		legacy_init(p, sizeof(struct mping), &ts, &addr, i);
+		legacy_swap(p);
+		barrier(p);
+	}
+	report("legacy build", start, num);
+
+	p->type = RECEIVER;
+	start = now_ns();
+	for (i = 0; i < num; i++) {
+		barrier(p);
+		if (legacy_check(p, sizeof(struct mping), RECEIVER))
+			abort();
+		sum += p->seq_no + p->tv.tv_usec;
+	}
+	report("legacy parse", start, num);
+
+	start = now_ns();
+	for (i = 0; i < num; i++) {
+		p->type = SENDER;
+		barrier(p);
+		if (legacy_check(p, sizeof(struct mping), SENDER))
+			abort();
+		p->type      = RECEIVER;
+		p->dest_host = p->src_host;
+		p->src_host  = addr;
+		TIMESPEC_TO_TIMEVAL(&p->rx_tv, &ts);
+		legacy_swap(p);
+		barrier(p);
+	}
+	report("legacy reflect", start, num);
+
+	return sum;
+}
+
+int main(int argc, char *argv[])
+{
+	struct mping *p = (struct mping *)buf;
+	struct timespec ts = { 0 };
+	inet_addr_t addr = { 0 };
+	unsigned int sum = 0;
+	uint64_t start;
+	long i, num;
+
+	num = argc > 1 ? atol(argv[1]) : ITERATIONS;
+	if (num <= 0)
+		num = ITERATIONS;
+
+	sum = legacy(p, num);
+
+	packet_version("2.1");
+	packet_init(p, sizeof(struct mping), 1, &addr, &addr, 4711);
+
+	start = now_ns();
+	for (i = 0; i < num; i++) {
+		ts.tv_nsec = i & 0x3fffffff;
+		packet_stamp(p, i, &ts);
+		barrier(p);
+	}
+	report("build", start, num);
+
+	p->type = RECEIVER;
+	start = now_ns();
+	for (i = 0; i < num; i++) {
+		struct timeval tv;
+
+		barrier(p);
+		if (packet_check(p, sizeof(struct mping), RECEIVER))
+			abort();
+		packet_get_tv(&p->tv, &tv);
+		sum += packet_seqno(p) + tv.tv_usec;
+	}
+	report("parse", start, num);
+
+	start = now_ns();
+	for (i = 0; i < num; i++) {
+		p->type = SENDER;
+		barrier(p);
+		if (packet_check(p, sizeof(struct mping), SENDER))
+			abort();
+		packet_reflect(p, sizeof(struct mping), &addr, &ts);
+		barrier(p);
+	}
+	report("reflect", start, num);
+
+	return sum == 42;	/* keep sum alive */
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
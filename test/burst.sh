@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+
+print "Phase 1: Verify burst mode ..."
+../mping -qr -i lo &
+PID=$!
+sleep 1
+
+../mping -s -B 4 -I 200 -c 8 -i lo -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "burst 1: 4 sent, 4 received" "/tmp/$NM.log" || FAIL "missing burst report"
+grep -q "2 bursts of 4, 0 with loss" "/tmp/$NM.log"  || FAIL "missing burst summary"
+
+if command -v python3 >/dev/null; then
+    print "Phase 2: Verify bursts with round-trip time longer than interval ..."
+    # reflector delaying each reply 50 ms, five intervals of 10 ms
+    python3 - <<-EOT &
+	import select, socket, struct, time
+	s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+	s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	s.bind(("", 4321))
+	lo = socket.inet_aton("127.0.0.1")
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, socket.inet_aton("225.1.2.3") + lo)
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, lo)
+	queue = []
+	while True:
+	    timeout = max(0, queue[0][0] - time.monotonic()) if queue else None
+	    if select.select([s], [], [], timeout)[0]:
+	        buf = s.recv(2048)
+	        if buf[4:5] == b"s":
+	            now = time.monotonic()
+	            rx = struct.pack("!QQ", int(now), int(now * 1000000) % 1000000)
+	            queue.append((now + 0.05, buf[:4] + b"r" + buf[5:296] + rx + buf[312:]))
+	    while queue and queue[0][0] <= time.monotonic():
+	        s.sendto(queue.pop(0)[1], ("225.1.2.3", 4321))
+	EOT
+    PID=$!
+    sleep 1
+
+    ../mping -s -B 4 -I 10 -c 32 -i lo -W 1 >"/tmp/$NM.log"
+    rc=$?
+    cat "/tmp/$NM.log"
+
+    kill -9 $PID 2>/dev/null
+    [ $rc -ne 0 ] && FAIL
+    [ "$(grep -c "burst [0-7]: 4 sent, 4 received" "/tmp/$NM.log")" -eq 8 ] || FAIL "late replies not in burst report"
+    grep -q "8 bursts of 4, 0 with loss" "/tmp/$NM.log"  || FAIL "missing burst summary"
+fi
+OK
@@ -0,0 +1,50 @@
+#!/bin/sh
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+
+cat <<-EOT >"/tmp/$NM.conf"
+	# group    port  msec
+	225.1.2.3
+	225.1.2.4  4321  100
+	225.1.2.5  5000  50
+	225.1.2.6  5000  200
+	EOT
+
+print "Phase 1: Verify flow mode ..."
+../mping -qr -f "/tmp/$NM.conf" -i lo &
+PID=$!
+sleep 1
+
+../mping -qs -f "/tmp/$NM.conf" -c 3 -I 300 -i lo -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "12 packets transmitted, 12 packets received" "/tmp/$NM.log" || FAIL "missing replies"
+grep -Eq "^225.1.2.5 +5000 +50 +3 +3 +0.0%" "/tmp/$NM.log"         || FAIL "missing flow table"
+
+print "Phase 2: Verify more groups per port than igmp_max_memberships ..."
+max=$(cat /proc/sys/net/ipv4/igmp_max_memberships)
+num=$((max + 10))
+for i in $(seq 1 $num); do
+    echo "225.1.3.$i"
+done >"/tmp/$NM.conf"
+
+../mping -qr -f "/tmp/$NM.conf" -i lo &
+PID=$!
+sleep 1
+
+../mping -qs -f "/tmp/$NM.conf" -c 2 -I 300 -i lo -W 1 >"/tmp/$NM.log"
+rc=$?
+tail -3 "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "$((num * 2)) packets transmitted, $((num * 2)) packets received" "/tmp/$NM.log" || FAIL "missing replies"
+OK
@@ -0,0 +1,32 @@
+#!/bin/sh
+# GSO/GRO over loopback, bursts of two sizes, the larger one exceeds
+# the MTU, so the sender has to fall back from GSO to one sendto() each
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+ip link set lo mtu 1500
+
+print "Phase 1: Verify every seqno is reflected with GSO/GRO ..."
+../mping -qr -g -i lo &
+PID=$!
+sleep 1
+
+../mping -s -g -B 8 -I 200 -c 16 -z 1000:3000:2000 -i lo -W 1 >"/tmp/$NM.log" 2>&1
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "32 packets transmitted, 32 packets received" "/tmp/$NM.log" || FAIL "missing replies"
+for seqno in $(seq 0 31); do
+    grep -q "seqno=$seqno " "/tmp/$NM.log" || FAIL "no reply to seqno $seqno"
+done
+grep -q "GSO send of 3320 byte segments failed" "/tmp/$NM.log" || FAIL "no GSO fallback"
+grep -q "burst 0: 8 sent, 8 received, dispersion NA" "/tmp/$NM.log" || FAIL "no GRO train at reflector"
+grep -q "burst 3: 8 sent, 8 received, dispersion [0-9]" "/tmp/$NM.log" || FAIL "missing dispersion"
+grep -q "(gso/gro)" "/tmp/$NM.log" || FAIL "missing gso/gro in summary"
+OK
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Verify probes from a v2.1 sender, with the shorter header, are reflected
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+check_dep python3
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+
+print "Phase 1: Verify reflecting v2.1 probes ..."
+../mping -qr -i lo &
+PID=$!
+sleep 1
+
+python3 - <<-EOT >"/tmp/$NM.log"
+	import socket, struct
+	s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+	s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	s.bind(("", 4321))
+	lo = socket.inet_aton("127.0.0.1")
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, socket.inet_aton("225.1.2.3") + lo)
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, lo)
+	s.settimeout(3)
+	# v2.1 header: version, type, ttl, pad, src, dest, seqno, pid, tv
+	probe = b"2.1\0s\1\0\0" + bytes(256) + struct.pack("!I", 7) + struct.pack("=i", 4711) + bytes(16)
+	s.sendto(probe, ("225.1.2.3", 4321))
+	while True:
+	    buf = s.recv(2048)
+	    if buf[4:5] == b"r":
+	        print("reply bytes=%d seqno=%d" % (len(buf), struct.unpack("!I", buf[264:268])[0]))
+	        break
+	EOT
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "reply bytes=288 seqno=7" "/tmp/$NM.log" || FAIL "missing reply to v2.1 probe"
+OK
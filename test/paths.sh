@@ -0,0 +1,71 @@
+#!/bin/sh
+# Two paths, veth pairs a0/b0 and a1/b1, reflector in its own netns
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+unshare -n sleep 60 &
+NS=$!
+sleep 1
+
+for i in 0 1; do
+    ip link add a$i type veth peer name b$i
+    ip link set b$i netns $NS
+    ip addr add 10.0.$i.1/24 dev a$i
+    ip link set a$i up
+    ip addr add fd00:$i::1/64 dev a$i nodad
+    nsenter -t $NS -n ip addr add 10.0.$i.2/24 dev b$i
+    nsenter -t $NS -n ip addr add fd00:$i::2/64 dev b$i nodad
+    nsenter -t $NS -n ip link set b$i up
+done
+nsenter -t $NS -n ip link set lo up
+
+print "Phase 1: Verify probing two paths ..."
+nsenter -t $NS -n ../mping -qr -i b0 -i b1 &
+PID=$!
+sleep 1
+
+../mping -s -I 200 -c 5 -i a0 -i a1 -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "via a1: seqno=4" "/tmp/$NM.log"            || FAIL "missing reply on path a1"
+[ "$(grep -cE '^ +[01] a[01] +5 +5 ' "/tmp/$NM.log")" -eq 2 ] || FAIL "missing per-path statistics"
+grep -q "skew a1-a0 .* (5 seqnos)" "/tmp/$NM.log"   || FAIL "missing path skew"
+
+print "Phase 2: Verify COUNT per path, deadline mode and reflector exit ..."
+nsenter -t $NS -n ../mping -qr -c 5 -i b0 -i b1 &
+PID=$!
+sleep 1
+
+../mping -s -I 200 -c 5 -w 10 -i a0 -i a1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+sleep 1
+if kill -0 $PID 2>/dev/null; then
+    kill -9 $PID $NS 2>/dev/null
+    FAIL "reflector did not exit after COUNT probes per path"
+fi
+[ $rc -ne 0 ] && FAIL
+[ "$(grep -cE '^ +[01] a[01] +5 +5 ' "/tmp/$NM.log")" -eq 2 ] || FAIL "missing COUNT replies per path"
+
+print "Phase 3: Verify IPv6 replies are counted on their own path ..."
+nsenter -t $NS -n ../mping -6 -qr -i b0 -i b1 &
+PID=$!
+sleep 1
+
+../mping -6 -s -I 200 -c 5 -i a0 -i a1 -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "10 packets transmitted, 10 packets received" "/tmp/$NM.log" || FAIL "replies counted twice"
+grep -q "from fd00:1::2 via a0" "/tmp/$NM.log"     && FAIL "reply on path a1 counted on a0"
+[ "$(grep -cE '^ +[01] a[01] +5 +5 ' "/tmp/$NM.log")" -eq 2 ] || FAIL "missing per-path statistics"
+kill $NS 2>/dev/null
+OK
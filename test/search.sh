@@ -0,0 +1,37 @@
+#!/bin/sh
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+
+print "Phase 1: Verify throughput search using reflector ..."
+../mping -qr -i lo &
+PID=$!
+sleep 1
+
+../mping -s -q -i lo -R 100:400 -T 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -qE "^ +320 +400 .* pass$" "/tmp/$NM.log" || FAIL "missing passed trial"
+grep -qE "^ +320 +400 +1.02$" "/tmp/$NM.log"   || FAIL "missing throughput"
+
+print "Phase 2: Verify throughput search using passive receiver ..."
+../mping -qnr -P -i lo &
+PID=$!
+sleep 1
+
+../mping -s -i lo -R 100:200 -T 1 -z 0:100:100 -C $PID >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -qE "^ +320 +200 +0.51$" "/tmp/$NM.log"   || FAIL "missing throughput at 320 bytes"
+grep -qE "^ +420 +200 +0.67$" "/tmp/$NM.log"   || FAIL "missing throughput at 420 bytes"
+OK
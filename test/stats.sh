@@ -0,0 +1,29 @@
+#!/bin/sh
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+
+print "Phase 1: Verify shared memory statistics ..."
+../mping -qr -i lo &
+PID=$!
+sleep 1
+
+../mping -qsP -c 4 -I 250 -i lo -W 1 &
+SND=$!
+sleep 1.5
+
+[ -e "/dev/shm/mping-$SND" ] || FAIL "missing /dev/shm/mping-$SND"
+../mping -S $SND -c 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+wait $SND
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+grep -q "packets received, round-trip" "/tmp/$NM.log" || FAIL "missing live statistics"
+[ -e "/dev/shm/mping-$SND" ] && FAIL "stale /dev/shm/mping-$SND"
+OK
@@ -0,0 +1,37 @@
+#!/bin/sh
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+print "Creating world ..."
+ip link set lo up
+ip link set lo multicast on
+ip link set lo mtu 1500
+
+print "Phase 1: Verify fragmented payload sweep ..."
+../mping -qr -i lo &
+PID=$!
+sleep 1
+
+../mping -qs -z 1000:9000:4000 -c 2 -I 100 -i lo -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+[ "$(grep -Ec "^ +[0-9]+ +2 +2 +0.0%" "/tmp/$NM.log")" -eq 3 ] || FAIL "missing sweep table"
+
+print "Phase 2: Verify sweep ends at MAX when not whole steps ..."
+../mping -qr -i lo &
+PID=$!
+sleep 1
+
+../mping -qs -z 0:1000:300 -c 2 -I 100 -i lo -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+kill -9 $PID 2>/dev/null
+[ $rc -ne 0 ] && FAIL
+[ "$(grep -Ec "^ +[0-9]+ +2 +2 +0.0%" "/tmp/$NM.log")" -eq 5 ] || FAIL "missing sweep steps"
+grep -Eq "^ +1320 +2 +2 +0.0%" "/tmp/$NM.log" || FAIL "missing MAX step"
+OK
@@ -0,0 +1,104 @@
+#!/bin/sh
+# XDP reflector in generic mode on a veth pair, a0/b0, reflector in its
+# own netns.  Requires real root, for loading BPF, and mping built with
+# make XDP=1, with the BPF object installed or XDP_OBJ=$PWD/xdp.bpf.o
+
+# shellcheck source=/dev/null
+. "$(dirname "$0")/lib.sh"
+
+check_dep clang
+[ "$(id -u)" -eq 0 ] || SKIP "Requires root, for loading BPF programs."
+ldconfig -p | grep -q libbpf || SKIP "Cannot find libbpf, skipping test."
+../mping -x -h 2>&1 | grep -q "not supported" && SKIP "mping built without XDP=1, skipping test."
+obj=$(grep -ao '/[[:graph:]]*/xdp\.bpf\.o' ../mping | head -1)
+[ -f "$obj" ] || SKIP "Cannot find $obj, install or build with XDP_OBJ, skipping test."
+
+print "Creating world ..."
+unshare -n sleep 60 &
+NS=$!
+unshare -n sleep 60 &
+RNS=$!
+sleep 1
+
+ip link add a0 netns $NS type veth peer name b0 netns $RNS
+nsenter -t $NS  -n ip addr add 10.0.0.1/24 dev a0
+nsenter -t $NS  -n ip link set a0 up
+nsenter -t $RNS -n ip addr add 10.0.0.2/24 dev b0
+nsenter -t $RNS -n ip link set b0 up
+
+print "Phase 1: Verify probes are reflected by XDP ..."
+nsenter -t $RNS -n ../mping -r -x -i b0 -c 5 >"/tmp/$NM.rlog" 2>&1 &
+PID=$!
+sleep 1
+
+nsenter -t $NS -n ../mping -s -I 200 -c 5 -i a0 -W 1 >"/tmp/$NM.log"
+rc=$?
+cat "/tmp/$NM.log"
+
+sleep 2
+cat "/tmp/$NM.rlog"
+if kill -0 $PID 2>/dev/null; then
+    kill -9 $PID $NS $RNS 2>/dev/null
+    FAIL "reflector did not exit after COUNT probes"
+fi
+if [ $rc -ne 0 ]; then
+    kill -9 $NS $RNS 2>/dev/null
+    FAIL
+fi
+grep -q "5 packets transmitted, 5 packets received" "/tmp/$NM.log" || FAIL "missing replies"
+grep -q "xdp: 5 packets received, 5 reflected, 0 invalid" "/tmp/$NM.rlog" || FAIL "not reflected by XDP"
+
+if command -v python3 >/dev/null; then
+    cat <<-EOT >"/tmp/$NM.py"
+	import socket, struct
+	s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+	s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	s.bind(("", 4321))
+	a0 = socket.inet_aton("10.0.0.1")
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, socket.inet_aton("225.1.2.3") + a0)
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, a0)
+	s.settimeout(3)
+	# v2.1 header: version, type, ttl, pad, src, dest, seqno, pid, tv
+	src = struct.pack("=H", socket.AF_INET) + bytes(2) + a0 + bytes(120)
+	probe = b"2.1\\0s\\1\\0\\0" + src + bytes(128) + struct.pack("!I", 7) + struct.pack("=i", 4711) + bytes(16)
+	s.sendto(probe, ("225.1.2.3", 4321))
+	while True:
+	    buf = s.recv(2048)
+	    if buf[4:5] == b"r":
+	        print("reply bytes=%d seqno=%d src=%s dst=%s" % (len(buf), struct.unpack("!I", buf[264:268])[0],
+	              socket.inet_ntoa(buf[12:16]), socket.inet_ntoa(buf[140:144])))
+	        # all but the tail of src_host, after sockaddr_in, unused
+	        print("reply " + (buf[:24] + buf[136:]).hex())
+	        break
+	EOT
+
+    print "Phase 2: Verify reflecting v2.1 probes by XDP ..."
+    nsenter -t $RNS -n ../mping -r -x -i b0 -c 1 >"/tmp/$NM.rlog" 2>&1 &
+    PID=$!
+    sleep 1
+
+    nsenter -t $NS -n python3 "/tmp/$NM.py" >"/tmp/$NM.log"
+    rc=$?
+    cat "/tmp/$NM.log"
+
+    sleep 2
+    cat "/tmp/$NM.rlog"
+    kill -9 $PID 2>/dev/null
+    [ $rc -ne 0 ] && FAIL
+    grep -q "reply bytes=288 seqno=7 src=10.0.0.2 dst=10.0.0.1" "/tmp/$NM.log" || FAIL "missing reply to v2.1 probe"
+    grep -q "1 reflected, 0 invalid" "/tmp/$NM.rlog" || FAIL "v2.1 probe not reflected by XDP"
+
+    print "Phase 3: Verify XDP and userspace reflector replies are the same ..."
+    nsenter -t $RNS -n ../mping -qr -i b0 -c 1 &
+    PID=$!
+    sleep 1
+
+    nsenter -t $NS -n python3 "/tmp/$NM.py" >"/tmp/$NM.ulog"
+    rc=$?
+    kill -9 $PID 2>/dev/null
+    [ $rc -ne 0 ] && FAIL
+    [ "$(grep "reply [0-9a-f]*$" "/tmp/$NM.log")" = "$(grep "reply [0-9a-f]*$" "/tmp/$NM.ulog")" ] || FAIL "replies differ"
+fi
+
+kill -9 $NS $RNS 2>/dev/null
+OK
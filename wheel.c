@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include "wheel.h"
+
+static void list_init(struct wheel_timer *head)
+{
+	head->next = head;
+	head->prev = head;
+}
+
+static int list_empty(const struct wheel_timer *head)
+{
+	return head->next == head;
+}
+
+static void list_add(struct wheel_timer *head, struct wheel_timer *t)
+{
+	t->prev = head->prev;
+	t->next = head;
+	head->prev->next = t;
+	head->prev = t;
+}
+
+static void list_del(struct wheel_timer *t)
+{
+	t->prev->next = t->next;
+	t->next->prev = t->prev;
+	t->next = t->prev = NULL;
+}
+
+void wheel_init(struct wheel *w, uint64_t now)
+{
+	int i, j;
+
+	w->now = now;
+	w->pending = 0;
+	for (i = 0; i < WHEEL_LEVELS; i++) {
+		for (j = 0; j < WHEEL_SLOTS; j++)
+			list_init(&w->slot[i][j]);
+	}
+}
+
+/*
+ * Place timer in the wheel, first is the earliest tick it can still be
+ * run at: the next tick when adding, or the current one when cascading,
+ * since wheel_run() has advanced now but not yet run its level 0 slot.
+ */
+static void insert(struct wheel *w, struct wheel_timer *t, uint64_t first)
+{
+	uint64_t expires = t->expires;
+	uint64_t delta;
+	int level;
+
+	/* already expired timers fire on first possible tick */
+	if (expires < first)
+		expires = first;
+	delta = expires - w->now;
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++) {
+		if (delta < (uint64_t)1 << (WHEEL_BITS * (level + 1)))
+			break;
+	}
+
+	/* clamp timers beyond the last level */
+	if (delta >= (uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+		expires = w->now + ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+	list_add(&w->slot[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK], t);
+}
+
+void wheel_add(struct wheel *w, struct wheel_timer *t, uint64_t expires)
+{
+	t->expires = expires;
+	insert(w, t, w->now + 1);
+	w->pending++;
+}
+
+void wheel_del(struct wheel *w, struct wheel_timer *t)
+{
+	if (!t->next)
+		return;
+
+	list_del(t);
+	w->pending--;
+}
+
+/* move all timers in a higher level slot down to lower levels */
+static void cascade(struct wheel *w, int level, int idx)
+{
+	struct wheel_timer *head = &w->slot[level][idx];
+
+	while (!list_empty(head)) {
+		struct wheel_timer *t = head->next;
+
+		list_del(t);
+		insert(w, t, w->now);
+	}
+}
+
+/*
+ * Advance wheel to tick now, calling cb for each expired timer.  The
+ * timer is unlinked before the callback, so it can be re-armed.
+ */
+void wheel_run(struct wheel *w, uint64_t now, wheel_cb_t cb, void *arg)
+{
+	while (w->now < now) {
+		struct wheel_timer *head;
+		uint64_t tick = ++w->now;
+		int level;
+
+		for (level = 1; level < WHEEL_LEVELS; level++) {
+			if (tick & (((uint64_t)1 << (WHEEL_BITS * level)) - 1))
+				break;
+			cascade(w, level, (tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+		}
+
+		head = &w->slot[0][tick & WHEEL_MASK];
+		while (!list_empty(head)) {
+			struct wheel_timer *t = head->next;
+
+			list_del(t);
+			w->pending--;
+			cb(t, arg);
+		}
+	}
+}
+
+/*
+ * Ticks until next timer may expire, scanning at most to the next
+ * cascade.  Returns -1 if no timers are armed.
+ */
+int64_t wheel_next(struct wheel *w)
+{
+	int64_t ticks;
+
+	if (!w->pending)
+		return -1;
+
+	for (ticks = 1; ticks <= WHEEL_SLOTS; ticks++) {
+		uint64_t tick = w->now + ticks;
+
+		if (!list_empty(&w->slot[0][tick & WHEEL_MASK]))
+			return ticks;
+		if (!(tick & WHEEL_MASK))
+			break;
+	}
+
+	return ticks;
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
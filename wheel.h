@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MPING_WHEEL_H_
+#define MPING_WHEEL_H_
+
+#include <stdint.h>
+
+/*
+ * Hierarchical timer wheel, 4 levels of 64 slots.  With 1 msec ticks
+ * timers up to ~4.6 hours ahead are supported, insert and delete are
+ * O(1), expiry is amortized O(1) per timer.
+ */
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+
+struct wheel_timer {
+	struct wheel_timer *next;
+	struct wheel_timer *prev;
+	uint64_t            expires;	/* absolute tick */
+};
+
+struct wheel {
+	uint64_t            now;	/* last processed tick */
+	int                 pending;	/* number of armed timers */
+	struct wheel_timer  slot[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+typedef void (*wheel_cb_t)(struct wheel_timer *t, void *arg);
+
+void    wheel_init   (struct wheel *w, uint64_t now);
+void    wheel_add    (struct wheel *w, struct wheel_timer *t, uint64_t expires);
+void    wheel_del    (struct wheel *w, struct wheel_timer *t);
+void    wheel_run    (struct wheel *w, uint64_t now, wheel_cb_t cb, void *arg);
+int64_t wheel_next   (struct wheel *w);
+
+#endif /* MPING_WHEEL_H_ */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * XDP reflector, turns mping probes around in the driver, or in generic
+ * mode just after it, without a trip through the stack and scheduler.
+ * IPv4 only, fragmented packets and packets with IP options are passed
+ * to the stack, where the userspace reflector handles them.
+ */
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/in.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_endian.h>
+
+#include "xdp.h"
+
+#define RECEIVER 'r'
+#define SENDER   's'
+
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, struct xdp_config);
+} config SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, XDP_CNT_MAX);
+	__type(key, __u32);
+	__type(value, __u64);
+} counters SEC(".maps");
+
+static __always_inline void count(__u32 key)
+{
+	__u64 *val = bpf_map_lookup_elem(&counters, &key);
+
+	if (val)
+		*val += 1;
+}
+
+static __always_inline void ip_csum(struct iphdr *ip)
+{
+	__u16 *p = (__u16 *)ip;
+	__u32 csum = 0;
+	int i;
+
+	ip->check = 0;
+#pragma unroll
+	for (i = 0; i < (int)sizeof(*ip) / 2; i++)
+		csum += p[i];
+
+	csum = (csum & 0xffff) + (csum >> 16);
+	csum = (csum & 0xffff) + (csum >> 16);
+	ip->check = ~csum;
+}
+
+SEC("xdp")
+int mping_reflect(struct xdp_md *ctx)
+{
+	void *end = (void *)(long)ctx->data_end;
+	void *data = (void *)(long)ctx->data;
+	struct ethhdr *eth = data;
+	struct xdp_config *cfg;
+	struct udphdr *udp;
+	struct iphdr *ip;
+	__u8 *mp, *type, *src, *dst, *rx;
+	__u32 key = 0;
+
+	cfg = bpf_map_lookup_elem(&config, &key);
+	if (!cfg)
+		return XDP_PASS;
+
+	if ((void *)(eth + 1) > end || eth->h_proto != bpf_htons(ETH_P_IP))
+		return XDP_PASS;
+
+	ip = (void *)(eth + 1);
+	if ((void *)(ip + 1) > end || ip->ihl != 5 || ip->protocol != IPPROTO_UDP)
+		return XDP_PASS;
+	if (ip->daddr != cfg->group || (ip->frag_off & bpf_htons(0x3fff)))
+		return XDP_PASS;
+
+	udp = (void *)(ip + 1);
+	if ((void *)(udp + 1) > end || udp->dest != cfg->port)
+		return XDP_PASS;
+	count(XDP_CNT_RX);
+
+	/* validate mping header, fixed offsets from mping */
+	mp = (void *)(udp + 1);
+	if ((void *)(mp + (cfg->min_len & (XDP_HDR_MAX - 1))) > end ||
+	    (void *)(mp + 4) > end ||
+	    *(__u32 *)mp != cfg->version)
+		goto invalid;
+
+	type = mp + (cfg->off_type & (XDP_HDR_MAX - 1));
+	if ((void *)(type + 1) > end || *type != SENDER)
+		goto invalid;
+	src = mp + (cfg->off_src & (XDP_HDR_MAX - 1));
+	if ((void *)(src + sizeof(struct sockaddr_in)) > end)
+		goto invalid;
+	dst = mp + (cfg->off_dst & (XDP_HDR_MAX - 1));
+	if ((void *)(dst + sizeof(struct sockaddr_in)) > end)
+		goto invalid;
+
+	/* turn around: type, addresses, like packet_reflect(), and arrival time */
+	*type = RECEIVER;
+	__builtin_memcpy(dst, src, sizeof(struct sockaddr_in));
+	__builtin_memcpy(src + __builtin_offsetof(struct sockaddr_in, sin_addr), &cfg->addr, 4);
+
+	/* v2.1 probes end before rx_tv, reflected without it */
+	rx = mp + (cfg->off_rx & (XDP_HDR_MAX - 1));
+	if (cfg->off_rx && (void *)(rx + 16) <= end) {
+		__u64 ns = bpf_ktime_get_ns();	/* CLOCK_MONOTONIC */
+		__u64 tv[2] = {
+			bpf_cpu_to_be64(ns / 1000000000),
+			bpf_cpu_to_be64((ns % 1000000000) / 1000)
+		};
+
+		__builtin_memcpy(rx, tv, sizeof(tv));
+	}
+
+	/* reply to group, like the userspace reflector, from our address */
+	ip->saddr = cfg->addr;
+	ip->ttl   = cfg->ttl;
+	ip_csum(ip);
+
+	udp->source = cfg->port;
+	udp->check  = 0;		/* optional for IPv4 */
+
+	__builtin_memcpy(eth->h_source, cfg->mac, ETH_ALEN);
+	count(XDP_CNT_TX);
+
+	return XDP_TX;
+invalid:
+	count(XDP_CNT_INVALID);
+	return XDP_PASS;
+}
+
+char _license[] SEC("license") = "Dual MIT/GPL";
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <err.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/if_link.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+
+#include "xdp.h"
+
+/* generic (skb) mode works on all interfaces, including veth */
+#define XDP_FLAGS (XDP_FLAGS_SKB_MODE | XDP_FLAGS_UPDATE_IF_NOEXIST)
+
+static struct bpf_object *obj;
+static int xdp_ifindex;
+static int counters_fd = -1;
+
+/* load BPF object, set config, and attach reflector to interface */
+int xdp_start(int ifindex, const struct xdp_config *cfg, const char *file)
+{
+	struct bpf_program *prog;
+	int config_fd, rc;
+	__u32 key = 0;
+
+	obj = bpf_object__open_file(file, NULL);
+	if (!obj) {
+		warn("failed opening %s", file);
+		return -1;
+	}
+
+	rc = bpf_object__load(obj);
+	if (rc) {
+		warnx("failed loading %s: %s", file, strerror(-rc));
+		goto fail;
+	}
+
+	prog = bpf_object__find_program_by_name(obj, "mping_reflect");
+	config_fd = bpf_object__find_map_fd_by_name(obj, "config");
+	counters_fd = bpf_object__find_map_fd_by_name(obj, "counters");
+	if (!prog || config_fd < 0 || counters_fd < 0) {
+		warnx("%s is not an mping XDP reflector", file);
+		goto fail;
+	}
+
+	if (bpf_map_update_elem(config_fd, &key, cfg, BPF_ANY)) {
+		warn("failed setting XDP reflector config");
+		goto fail;
+	}
+
+	rc = bpf_xdp_attach(ifindex, bpf_program__fd(prog), XDP_FLAGS, NULL);
+	if (rc) {
+		warnx("failed attaching XDP reflector to ifindex %d: %s", ifindex, strerror(-rc));
+		goto fail;
+	}
+	xdp_ifindex = ifindex;
+	atexit(xdp_stop);
+
+	return 0;
+fail:
+	bpf_object__close(obj);
+	obj = NULL;
+	counters_fd = -1;
+
+	return -1;
+}
+
+/* sum per-CPU counters */
+int xdp_stats(uint64_t cnt[XDP_CNT_MAX])
+{
+	int ncpus = libbpf_num_possible_cpus();
+	__u64 *val;
+	__u32 key;
+
+	if (counters_fd < 0 || ncpus <= 0)
+		return -1;
+
+	val = calloc(ncpus, sizeof(*val));
+	if (!val)
+		return -1;
+
+	for (key = 0; key < XDP_CNT_MAX; key++) {
+		int i;
+
+		cnt[key] = 0;
+		if (bpf_map_lookup_elem(counters_fd, &key, val))
+			continue;
+		for (i = 0; i < ncpus; i++)
+			cnt[key] += val[i];
+	}
+	free(val);
+
+	return 0;
+}
+
+/* detach, the program otherwise stays on the interface after we exit */
+void xdp_stop(void)
+{
+	if (!obj)
+		return;
+
+	if (xdp_ifindex)
+		bpf_xdp_detach(xdp_ifindex, XDP_FLAGS_SKB_MODE, NULL);
+	bpf_object__close(obj);
+	obj = NULL;
+	counters_fd = -1;
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */
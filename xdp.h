@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026  Joachim Wiberg <troglobit@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MPING_XDP_H_
+#define MPING_XDP_H_
+
+#include <linux/types.h>
+
+/*
+ * Shared between the XDP reflector, xdp.bpf.c, and the loader, xdp.c.
+ * The mping header offsets are filled in by mping, using offsetof(), so
+ * the BPF program does not depend on the host's struct layout.
+ */
+struct xdp_config {
+	__u32           group;		/* multicast group, network order */
+	__u32           addr;		/* our address, network order */
+	__u32           version;	/* mping version string, as a word */
+	__u16           port;		/* UDP port, network order */
+	__u8            ttl;		/* IP TTL of replies */
+	__u8            mac[6];		/* our MAC address */
+	__u16           min_len;	/* shortest probe, v2.1 header */
+	__u16           off_type;	/* offset of type */
+	__u16           off_src;	/* offset of src_host, sockaddr_in */
+	__u16           off_dst;	/* offset of dest_host, sockaddr_in */
+	__u16           off_rx;		/* offset of rx_tv, 0 if not 64-bit */
+};
+
+enum {
+	XDP_CNT_RX = 0,			/* probes matching group and port */
+	XDP_CNT_TX,			/* reflected probes */
+	XDP_CNT_INVALID,		/* version, type, or length mismatch */
+	XDP_CNT_MAX
+};
+
+#define XDP_HDR_MAX     512		/* max offset into mping header */
+
+#ifndef __bpf__
+#include <stdint.h>
+
+int  xdp_start (int ifindex, const struct xdp_config *cfg, const char *file);
+int  xdp_stats (uint64_t cnt[XDP_CNT_MAX]);
+void xdp_stop  (void);
+#endif
+
+#endif /* MPING_XDP_H_ */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: t
+ *  c-file-style: "linux"
+ * End:
+ */